@@ -38,17 +38,14 @@ marcher_template = Template('''
         }
         int height = static_cast<int>(info.shape[0]); // height
         int width = static_cast<int>(info.shape[1]); // width
-        auto m_ptr = new ${cpp_class_name} {height, width, h, no_speed_func};
-        memcpy(
-          (double *) m_ptr->get_s_cache_data(),
-          info.ptr,
-          sizeof(double)*height*width);
-        return m_ptr;
+        return new ${cpp_class_name} {height, width, h, borrow_s_cache(arr)};
       }),
       "s_cache"_a,
       "h"_a = 1.0)
     .def("run", &${cpp_class_name}::run)
     .def("step", &${cpp_class_name}::step)
+    .def("reset", &${cpp_class_name}::reset)
+    .def("reserve_heap", &${cpp_class_name}::reserve_heap, "capacity"_a)
     .def("__getitem__", [] (${cpp_class_name} const & m,
                             std::tuple<int, int> index) {
         return m(std::get<0>(index), std::get<1>(index));
@@ -98,12 +95,40 @@ marchers3d = {
     'olim26_rhr': 'Olim26Rect',
     'olim3d_hu_mp0': 'Olim3dHuMid0',
     'olim3d_hu_mp1': 'Olim3dHuMid1',
-    'olim3d_hu_rhr': 'Olim3dHuRect'}
+    'olim3d_hu_rhr': 'Olim3dHuRect',
+    'olim6_mp0_compact': 'Olim6Mid0Compact',
+    'olim6_mp1_compact': 'Olim6Mid1Compact',
+    'olim6_rhr_compact': 'Olim6RectCompact',
+    'olim18_mp0_compact': 'Olim18Mid0Compact',
+    'olim18_mp1_compact': 'Olim18Mid1Compact',
+    'olim18_rhr_compact': 'Olim18RectCompact',
+    'olim26_mp0_compact': 'Olim26Mid0Compact',
+    'olim26_mp1_compact': 'Olim26Mid1Compact',
+    'olim26_rhr_compact': 'Olim26RectCompact',
+    'olim3d_hu_mp0_compact': 'Olim3dHuMid0Compact',
+    'olim3d_hu_mp1_compact': 'Olim3dHuMid1Compact',
+    'olim3d_hu_rhr_compact': 'Olim3dHuRectCompact',
+    'olim6_mp0_float': 'Olim6Mid0Float',
+    'olim6_mp1_float': 'Olim6Mid1Float',
+    'olim6_rhr_float': 'Olim6RectFloat',
+    'olim18_mp0_float': 'Olim18Mid0Float',
+    'olim18_mp1_float': 'Olim18Mid1Float',
+    'olim18_rhr_float': 'Olim18RectFloat',
+    'olim26_mp0_float': 'Olim26Mid0Float',
+    'olim26_mp1_float': 'Olim26Mid1Float',
+    'olim26_rhr_float': 'Olim26RectFloat',
+    'olim3d_hu_mp0_float': 'Olim3dHuMid0Float',
+    'olim3d_hu_mp1_float': 'Olim3dHuMid1Float',
+    'olim3d_hu_rhr_float': 'Olim3dHuRectFloat'}
 
 # TODO: see comment above for `marcher_template' variable.
 marcher3d_template = Template('''
 py::class_<${cpp_class_name}>(m, "${py_class_name}", py::buffer_protocol())
     .def_buffer([] (${cpp_class_name} & m_) -> py::buffer_info {
+        if constexpr (${cpp_class_name}::is_tiled) {
+          throw std::runtime_error(
+            "The node array is tiled: use get_values() instead");
+        }
         auto const format =
           py::format_descriptor<${cpp_class_name}::float_type>::format();
         return {
@@ -116,10 +141,10 @@ py::class_<${cpp_class_name}>(m, "${py_class_name}", py::buffer_protocol())
             m_.get_width(),
             m_.get_depth(),
           },
-          { // i, j, k
-            sizeof(${cpp_class_name}::node_type),
-            sizeof(${cpp_class_name}::node_type)*m_.get_width(),
-            sizeof(${cpp_class_name}::node_type)*m_.get_width()*m_.get_height(),
+          { // i, j, k (the node array is padded: see marcher_3d::node_index)
+            sizeof(${cpp_class_name}::node_type)*m_.get_node_stride(0),
+            sizeof(${cpp_class_name}::node_type)*m_.get_node_stride(1),
+            sizeof(${cpp_class_name}::node_type)*m_.get_node_stride(2),
           }
         };
       })
@@ -148,17 +173,18 @@ py::class_<${cpp_class_name}>(m, "${py_class_name}", py::buffer_protocol())
         int width = static_cast<int>(info.shape[1]); // width
         int depth = static_cast<int>(info.shape[2]); // depth
 
-        auto m_ptr = new ${cpp_class_name} {height, width, depth, h, no_speed_func};
-        memcpy(
-          (double *) m_ptr->get_s_cache_data(),
-          info.ptr,
-          sizeof(double)*height*width*depth);
-        return m_ptr;
+        // The marcher copies the speed function cache after all if
+        // it has to convert it to float_type or reorder it (if the
+        // node array is tiled).
+        return new ${cpp_class_name} {
+          height, width, depth, h, borrow_s_cache(arr)};
       }),
       "s_cache"_a,
       "h"_a = 1.0)
     .def("run", &${cpp_class_name}::run)
     .def("step", &${cpp_class_name}::step)
+    .def("reset", &${cpp_class_name}::reset)
+    .def("reserve_heap", &${cpp_class_name}::reserve_heap, "capacity"_a)
     .def("__getitem__", [] (${cpp_class_name} const & m,
                             std::tuple<int, int, int> index) {
         return m(std::get<0>(index), std::get<1>(index), std::get<2>(index));
@@ -182,6 +208,12 @@ py::class_<${cpp_class_name}>(m, "${py_class_name}", py::buffer_protocol())
       "value"_a = 0.0)
     .def("get_speed", &${cpp_class_name}::get_speed, "i"_a, "j"_a, "k"_a)
     .def("get_value", &${cpp_class_name}::get_value, "i"_a, "j"_a, "k"_a)
+    .def("get_values", [] (${cpp_class_name} const & m) {
+        py::array_t<double, py::array::f_style> values {
+          {m.get_height(), m.get_width(), m.get_depth()}};
+        m.copy_values(values.mutable_data());
+        return values;
+      })
     .def(
       "set_node_fac_center",
       &${cpp_class_name}::set_node_fac_center,
@@ -191,12 +223,68 @@ py::class_<${cpp_class_name}>(m, "${py_class_name}", py::buffer_protocol())
       "fc"_a)
     .def("get_height", &${cpp_class_name}::get_height)
     .def("get_width", &${cpp_class_name}::get_width)
-    .def("get_depth", &${cpp_class_name}::get_depth);
+    .def("get_depth", &${cpp_class_name}::get_depth)
+    .def_static(
+      "run_batch",
+      [] (py::array_t<double, py::array::f_style | py::array::forcecast> arr,
+          double h,
+          std::vector<std::vector<std::tuple<int, int, int, double>>> const & sources,
+          py::array_t<double, py::array::f_style> out,
+          int num_threads) {
+        // Solve once for each list of (i, j, k, value) boundary nodes
+        // in `sources', writing the solution for sources[l] to
+        // out[:, :, :, l] (see batch_marcher_3d).
+        py::buffer_info info = arr.request();
+        if (info.ndim != 3) {
+          throw std::runtime_error("Expected `ndim == 3'");
+        }
+        for (int d = 0; d < 3; ++d) {
+          if (info.shape[d] > std::numeric_limits<int>::max()) {
+            throw std::runtime_error(
+              "Error: size of a dimension is larger than INT_MAX");
+          }
+        }
+        int height = static_cast<int>(info.shape[0]); // height
+        int width = static_cast<int>(info.shape[1]); // width
+        int depth = static_cast<int>(info.shape[2]); // depth
+        if (out.ndim() != 4 || out.shape(0) != height ||
+            out.shape(1) != width || out.shape(2) != depth ||
+            static_cast<size_t>(out.shape(3)) != sources.size()) {
+          throw std::runtime_error(
+            "Expected `out.shape == s_cache.shape + (len(sources),)'");
+        }
+
+        using batch_t = batch_marcher_3d<${cpp_class_name}>;
+        std::vector<std::vector<batch_t::boundary_node>> nodes(sources.size());
+        for (size_t l = 0; l < sources.size(); ++l) {
+          for (auto const & n: sources[l]) {
+            int i = std::get<0>(n), j = std::get<1>(n), k = std::get<2>(n);
+            if (i < 0 || i >= height || j < 0 || j >= width ||
+                k < 0 || k >= depth) {
+              throw std::runtime_error("Boundary node out of bounds");
+            }
+            nodes[l].push_back({i, j, k, std::get<3>(n)});
+          }
+        }
+
+        batch_t batch {
+          height, width, depth, h, (double const *) info.ptr, num_threads};
+        double * out_ptr = out.mutable_data();
+        py::gil_scoped_release release;
+        batch.run(nodes, out_ptr);
+      },
+      "s_cache"_a,
+      "h"_a,
+      "sources"_a,
+      py::arg("out").noconvert(),
+      "num_threads"_a = 0);
 ''')
 
 def build_src_txt(args):
     src_txt = '''
+#include <algorithm>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include <pybind11/pybind11.h>
@@ -208,6 +296,7 @@ def build_src_txt(args):
 
 #include <basic_marcher.hpp>
 #include <basic_marcher_3d.hpp>
+#include <batch_marcher_3d.hpp>
 #include <olim.hpp>
 #include <olim3d.hpp>
 '''
@@ -220,6 +309,19 @@ using namespace py::literals;
 using speed_function = std::function<double(double, double)>;
 using speed_function_3d = std::function<double(double, double, double)>;
 
+// Let a marcher use the data of `arr' as its speed function cache
+// without copying it. The shared_ptr's deleter holds a reference to
+// `arr', so the array stays alive for as long as the marcher does
+// (arr should already have the layout the marcher expects).
+static std::shared_ptr<double const> borrow_s_cache(py::array arr) {
+  auto ptr = static_cast<double const *>(arr.data());
+  return {ptr, [arr] (double const *) mutable {
+    // The marcher may be destroyed without holding the GIL.
+    py::gil_scoped_acquire gil;
+    arr.release().dec_ref();
+  }};
+}
+
 PYBIND11_MODULE(pyolim, m) {
   m.doc() = "Testing testing";
 '''
@@ -0,0 +1,497 @@
+#include <olim.hpp>
+#include <olim3d.hpp>
+#include <parallel_marcher_3d.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using clock_type = std::chrono::high_resolution_clock;
+
+template <class marcher_3d>
+double time_marcher_3d(int n, marcher_3d *& m) {
+  double h = 2./(n - 1);
+  int i = n/2;
+  m = new marcher_3d {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+  auto t0 = clock_type::now();
+  m->add_boundary_node(i, i, i);
+  m->run();
+  auto t1 = clock_type::now();
+  return std::chrono::duration<double>(t1 - t0).count();
+}
+
+/**
+ * Time a marcher using the default binary heap against the same
+ * marcher using a different queue, and report the speedup and the
+ * largest difference between the two solutions.
+ */
+template <class heap_marcher_3d, class other_marcher_3d>
+void compare_queues(int n) {
+  heap_marcher_3d * m_heap;
+  other_marcher_3d * m_other;
+  double t_heap = time_marcher_3d(n, m_heap);
+  double t_other = time_marcher_3d(n, m_other);
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        max_diff = fmax(max_diff, fabs(m_heap->get_value(i, j, k) -
+                                       m_other->get_value(i, j, k)));
+      }
+    }
+  }
+
+  std::cout << "heap: " << t_heap << "s, other: " << t_other << "s, "
+            << "speedup: " << t_heap/t_other << ", "
+            << "max |u_heap - u_other|: " << max_diff << std::endl;
+
+  delete m_heap;
+  delete m_other;
+}
+
+template <template <class> class queue>
+void compare_queues(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0")
+    compare_queues<olim6_mp0, olim3d_mp0<olim6_groups, queue>>(n);
+  if (marcher_name == "olim6_mp1")
+    compare_queues<olim6_mp1, olim3d_mp1<olim6_groups, queue>>(n);
+  if (marcher_name == "olim6_rhr")
+    compare_queues<olim6_rhr, olim3d_rhr<olim6_groups, queue>>(n);
+
+  if (marcher_name == "olim18_mp0")
+    compare_queues<olim18_mp0, olim3d_mp0<olim18_groups, queue>>(n);
+  if (marcher_name == "olim18_mp1")
+    compare_queues<olim18_mp1, olim3d_mp1<olim18_groups, queue>>(n);
+  if (marcher_name == "olim18_rhr")
+    compare_queues<olim18_rhr, olim3d_rhr<olim18_groups, queue>>(n);
+
+  if (marcher_name == "olim26_mp0")
+    compare_queues<olim26_mp0, olim3d_mp0<olim26_groups, queue>>(n);
+  if (marcher_name == "olim26_mp1")
+    compare_queues<olim26_mp1, olim3d_mp1<olim26_groups, queue>>(n);
+  if (marcher_name == "olim26_rhr")
+    compare_queues<olim26_rhr, olim3d_rhr<olim26_groups, queue>>(n);
+}
+
+/**
+ * Time a marcher storing its values in double precision against the
+ * same marcher storing them in single precision, and report the
+ * speedup, the largest error of each solution (for a point source in
+ * the middle of the grid with a constant speed function, the exact
+ * solution is the distance to the source), and the largest difference
+ * between the two solutions.
+ */
+template <class double_marcher_3d, class float_marcher_3d>
+void compare_precisions(int n) {
+  double_marcher_3d * m_double;
+  float_marcher_3d * m_float;
+  double t_double = time_marcher_3d(n, m_double);
+  double t_float = time_marcher_3d(n, m_float);
+
+  double h = 2./(n - 1), error_double = 0, error_float = 0, max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    double y = h*i - 1;
+    for (int j = 0; j < n; ++j) {
+      double x = h*j - 1;
+      for (int k = 0; k < n; ++k) {
+        double z = h*k - 1, u = sqrt(x*x + y*y + z*z);
+        double u_double = m_double->get_value(i, j, k);
+        double u_float = m_float->get_value(i, j, k);
+        error_double = fmax(error_double, fabs(u - u_double));
+        error_float = fmax(error_float, fabs(u - u_float));
+        max_diff = fmax(max_diff, fabs(u_double - u_float));
+      }
+    }
+  }
+
+  std::cout << "double: " << t_double << "s, float: " << t_float << "s, "
+            << "speedup: " << t_double/t_float << ", "
+            << "max |u - u_double|: " << error_double << ", "
+            << "max |u - u_float|: " << error_float << ", "
+            << "max |u_double - u_float|: " << max_diff << std::endl;
+
+  delete m_double;
+  delete m_float;
+}
+
+void compare_precisions(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0")
+    compare_precisions<olim6_mp0, olim6_mp0_float>(n);
+  if (marcher_name == "olim6_mp1")
+    compare_precisions<olim6_mp1, olim6_mp1_float>(n);
+  if (marcher_name == "olim6_rhr")
+    compare_precisions<olim6_rhr, olim6_rhr_float>(n);
+
+  if (marcher_name == "olim18_mp0")
+    compare_precisions<olim18_mp0, olim18_mp0_float>(n);
+  if (marcher_name == "olim18_mp1")
+    compare_precisions<olim18_mp1, olim18_mp1_float>(n);
+  if (marcher_name == "olim18_rhr")
+    compare_precisions<olim18_rhr, olim18_rhr_float>(n);
+
+  if (marcher_name == "olim26_mp0")
+    compare_precisions<olim26_mp0, olim26_mp0_float>(n);
+  if (marcher_name == "olim26_mp1")
+    compare_precisions<olim26_mp1, olim26_mp1_float>(n);
+  if (marcher_name == "olim26_rhr")
+    compare_precisions<olim26_rhr, olim26_rhr_float>(n);
+
+  if (marcher_name == "olim3d_hu_mp0")
+    compare_precisions<olim3d_hu_mp0, olim3d_hu_mp0_float>(n);
+  if (marcher_name == "olim3d_hu_mp1")
+    compare_precisions<olim3d_hu_mp1, olim3d_hu_mp1_float>(n);
+  if (marcher_name == "olim3d_hu_rhr")
+    compare_precisions<olim3d_hu_rhr, olim3d_hu_rhr_float>(n);
+}
+
+/**
+ * Time a marcher which solves all of its tetrahedron updates against
+ * the same marcher doing the triangle updates first (see
+ * tetra_strategy in olim3d.hpp).
+ */
+template <class solve_all_marcher_3d, class tris_first_marcher_3d>
+void compare_tetra_strategies(int n) {
+  solve_all_marcher_3d * m_solve_all;
+  tris_first_marcher_3d * m_tris_first;
+  double t_solve_all = time_marcher_3d(n, m_solve_all);
+  double t_tris_first = time_marcher_3d(n, m_tris_first);
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        max_diff = fmax(max_diff, fabs(m_solve_all->get_value(i, j, k) -
+                                       m_tris_first->get_value(i, j, k)));
+      }
+    }
+  }
+
+  std::cout << "solve all: " << t_solve_all << "s, "
+            << "tris first: " << t_tris_first << "s, "
+            << "speedup: " << t_solve_all/t_tris_first << ", "
+            << "max |u_solve_all - u_tris_first|: " << max_diff << std::endl;
+
+  delete m_solve_all;
+  delete m_tris_first;
+}
+
+void compare_tetra_strategies(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0")
+    compare_tetra_strategies<olim6_mp0, olim6_mp0_tris_first>(n);
+  if (marcher_name == "olim6_mp1")
+    compare_tetra_strategies<olim6_mp1, olim6_mp1_tris_first>(n);
+  if (marcher_name == "olim6_rhr")
+    compare_tetra_strategies<olim6_rhr, olim6_rhr_tris_first>(n);
+
+  if (marcher_name == "olim18_mp0")
+    compare_tetra_strategies<olim18_mp0, olim18_mp0_tris_first>(n);
+  if (marcher_name == "olim18_mp1")
+    compare_tetra_strategies<olim18_mp1, olim18_mp1_tris_first>(n);
+  if (marcher_name == "olim18_rhr")
+    compare_tetra_strategies<olim18_rhr, olim18_rhr_tris_first>(n);
+
+  if (marcher_name == "olim26_mp0")
+    compare_tetra_strategies<olim26_mp0, olim26_mp0_tris_first>(n);
+  if (marcher_name == "olim26_mp1")
+    compare_tetra_strategies<olim26_mp1, olim26_mp1_tris_first>(n);
+  if (marcher_name == "olim26_rhr")
+    compare_tetra_strategies<olim26_rhr, olim26_rhr_tris_first>(n);
+
+  if (marcher_name == "olim3d_hu_mp0")
+    compare_tetra_strategies<olim3d_hu_mp0, olim3d_hu_mp0_tris_first>(n);
+  if (marcher_name == "olim3d_hu_mp1")
+    compare_tetra_strategies<olim3d_hu_mp1, olim3d_hu_mp1_tris_first>(n);
+  if (marcher_name == "olim3d_hu_rhr")
+    compare_tetra_strategies<olim3d_hu_rhr, olim3d_hu_rhr_tris_first>(n);
+}
+
+template <class node, template <class> class queue>
+void run_virtually(abstract_marcher<node, queue> & m) {
+  m.run();
+}
+
+/**
+ * Time a marcher run through the abstract_marcher interface (which
+ * calls visit_neighbors_impl and update_impl virtually) against the
+ * same marcher run directly (which dispatches statically: see
+ * abstract_marcher.hpp).
+ */
+template <class marcher>
+void compare_dispatch_2d(int n) {
+  double h = 2./(n - 1);
+  int i0 = n/2;
+  marcher m_virtual {n, n, h, (speed_func) default_speed_func, 1., 1.};
+  marcher m_static {n, n, h, (speed_func) default_speed_func, 1., 1.};
+
+  auto t0 = clock_type::now();
+  m_virtual.add_boundary_node(i0, i0);
+  run_virtually(m_virtual);
+  auto t1 = clock_type::now();
+  m_static.add_boundary_node(i0, i0);
+  m_static.run();
+  auto t2 = clock_type::now();
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      max_diff = fmax(max_diff, fabs(m_virtual.get_value(i, j) -
+                                     m_static.get_value(i, j)));
+    }
+  }
+
+  double t_virtual = std::chrono::duration<double>(t1 - t0).count();
+  double t_static = std::chrono::duration<double>(t2 - t1).count();
+  std::cout << "virtual: " << t_virtual << "s, static: " << t_static << "s, "
+            << "speedup: " << t_virtual/t_static << ", "
+            << "max |u_virtual - u_static|: " << max_diff << std::endl;
+}
+
+template <class marcher_3d>
+void compare_dispatch_3d(int n) {
+  double h = 2./(n - 1);
+  int i0 = n/2;
+  marcher_3d m_virtual {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+  marcher_3d m_static {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+
+  auto t0 = clock_type::now();
+  m_virtual.add_boundary_node(i0, i0, i0);
+  run_virtually(m_virtual);
+  auto t1 = clock_type::now();
+  m_static.add_boundary_node(i0, i0, i0);
+  m_static.run();
+  auto t2 = clock_type::now();
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        max_diff = fmax(max_diff, fabs(m_virtual.get_value(i, j, k) -
+                                       m_static.get_value(i, j, k)));
+      }
+    }
+  }
+
+  double t_virtual = std::chrono::duration<double>(t1 - t0).count();
+  double t_static = std::chrono::duration<double>(t2 - t1).count();
+  std::cout << "virtual: " << t_virtual << "s, static: " << t_static << "s, "
+            << "speedup: " << t_virtual/t_static << ", "
+            << "max |u_virtual - u_static|: " << max_diff << std::endl;
+}
+
+void compare_dispatch(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim4_mp0") compare_dispatch_2d<olim4_mp0>(n);
+  if (marcher_name == "olim4_rhr") compare_dispatch_2d<olim4_rhr>(n);
+  if (marcher_name == "olim8_mp0") compare_dispatch_2d<olim8_mp0>(n);
+  if (marcher_name == "olim8_rhr") compare_dispatch_2d<olim8_rhr>(n);
+
+  if (marcher_name == "olim6_mp0") compare_dispatch_3d<olim6_mp0>(n);
+  if (marcher_name == "olim6_rhr") compare_dispatch_3d<olim6_rhr>(n);
+  if (marcher_name == "olim18_rhr") compare_dispatch_3d<olim18_rhr>(n);
+  if (marcher_name == "olim26_rhr") compare_dispatch_3d<olim26_rhr>(n);
+}
+
+/**
+ * Construct and run a lot of small marchers one after another, and
+ * report how long it takes to construct one of them and to solve
+ * with it. This is mostly here to check that constructing a marcher
+ * doesn't cost much more than its grid (e.g., that olim3d_hu's tables
+ * aren't rebuilt for each one: see hu_geometry).
+ */
+template <class marcher_3d>
+void time_many_small(int n) {
+  constexpr int num_marchers = 1000;
+
+  double h = 2./(n - 1);
+  int i0 = n/2;
+  double t_construct = 0, t_run = 0;
+  for (int k = 0; k < num_marchers; ++k) {
+    auto t0 = clock_type::now();
+    marcher_3d m {
+      n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+    auto t1 = clock_type::now();
+    m.add_boundary_node(i0, i0, i0);
+    m.run();
+    auto t2 = clock_type::now();
+    t_construct += std::chrono::duration<double>(t1 - t0).count();
+    t_run += std::chrono::duration<double>(t2 - t1).count();
+  }
+
+  std::cout << "construct: " << 1e6*t_construct/num_marchers << "us, "
+            << "run: " << 1e6*t_run/num_marchers << "us "
+            << "(average over " << num_marchers << " marchers)" << std::endl;
+}
+
+void time_many_small(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0") time_many_small<olim6_mp0>(n);
+  if (marcher_name == "olim6_mp1") time_many_small<olim6_mp1>(n);
+  if (marcher_name == "olim6_rhr") time_many_small<olim6_rhr>(n);
+  if (marcher_name == "olim18_mp0") time_many_small<olim18_mp0>(n);
+  if (marcher_name == "olim18_mp1") time_many_small<olim18_mp1>(n);
+  if (marcher_name == "olim18_rhr") time_many_small<olim18_rhr>(n);
+  if (marcher_name == "olim26_mp0") time_many_small<olim26_mp0>(n);
+  if (marcher_name == "olim26_mp1") time_many_small<olim26_mp1>(n);
+  if (marcher_name == "olim26_rhr") time_many_small<olim26_rhr>(n);
+  if (marcher_name == "olim3d_hu_mp0") time_many_small<olim3d_hu_mp0>(n);
+  if (marcher_name == "olim3d_hu_mp1") time_many_small<olim3d_hu_mp1>(n);
+  if (marcher_name == "olim3d_hu_rhr") time_many_small<olim3d_hu_rhr>(n);
+}
+
+/**
+ * Time a marcher against parallel_marcher_3d using the same marcher
+ * for each of its blocks (with the default block size, and one
+ * thread per hardware thread).
+ */
+template <class marcher_3d>
+void compare_parallel(int n) {
+  marcher_3d * m_serial;
+  double t_serial = time_marcher_3d(n, m_serial);
+
+  double h = 2./(n - 1);
+  int i0 = n/2;
+  parallel_marcher_3d<marcher_3d> m_parallel {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+  auto t0 = clock_type::now();
+  m_parallel.add_boundary_node(i0, i0, i0);
+  m_parallel.run();
+  auto t1 = clock_type::now();
+  double t_parallel = std::chrono::duration<double>(t1 - t0).count();
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        max_diff = fmax(max_diff, fabs(m_serial->get_value(i, j, k) -
+                                       m_parallel.get_value(i, j, k)));
+      }
+    }
+  }
+
+  std::cout << "serial: " << t_serial << "s, "
+            << "parallel: " << t_parallel << "s "
+            << "(" << m_parallel.get_num_threads() << " threads, "
+            << m_parallel.get_num_blocks() << " blocks, "
+            << m_parallel.get_num_rounds() << " rounds, "
+            << m_parallel.get_num_block_runs() << " block runs), "
+            << "speedup: " << t_serial/t_parallel << ", "
+            << "max |u_serial - u_parallel|: " << max_diff << std::endl;
+
+  delete m_serial;
+}
+
+void compare_parallel(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0") compare_parallel<olim6_mp0>(n);
+  if (marcher_name == "olim6_mp1") compare_parallel<olim6_mp1>(n);
+  if (marcher_name == "olim6_rhr") compare_parallel<olim6_rhr>(n);
+  if (marcher_name == "olim18_mp0") compare_parallel<olim18_mp0>(n);
+  if (marcher_name == "olim18_mp1") compare_parallel<olim18_mp1>(n);
+  if (marcher_name == "olim18_rhr") compare_parallel<olim18_rhr>(n);
+  if (marcher_name == "olim26_mp0") compare_parallel<olim26_mp0>(n);
+  if (marcher_name == "olim26_mp1") compare_parallel<olim26_mp1>(n);
+  if (marcher_name == "olim26_rhr") compare_parallel<olim26_rhr>(n);
+  if (marcher_name == "olim3d_hu_mp0") compare_parallel<olim3d_hu_mp0>(n);
+  if (marcher_name == "olim3d_hu_mp1") compare_parallel<olim3d_hu_mp1>(n);
+  if (marcher_name == "olim3d_hu_rhr") compare_parallel<olim3d_hu_rhr>(n);
+}
+
+/**
+ * Time a marcher against fast sweeping with the same marcher, both
+ * serially (marcher_3d::run_sweeps) and in parallel
+ * (parallel_marcher_3d::run_sweeps, with the default block size).
+ */
+template <class marcher_3d>
+void compare_sweeping(int n) {
+  marcher_3d * m;
+  double t_march = time_marcher_3d(n, m);
+
+  double h = 2./(n - 1);
+  int i0 = n/2;
+  marcher_3d m_sweep {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+  auto t0 = clock_type::now();
+  m_sweep.add_boundary_node(i0, i0, i0);
+  int num_sweeps = m_sweep.run_sweeps();
+  auto t1 = clock_type::now();
+  double t_sweep = std::chrono::duration<double>(t1 - t0).count();
+
+  parallel_marcher_3d<marcher_3d> m_parallel {
+    n, n, n, h, (speed_func_3d) default_speed_func, 1., 1., 1.};
+  t0 = clock_type::now();
+  m_parallel.add_boundary_node(i0, i0, i0);
+  m_parallel.run_sweeps();
+  t1 = clock_type::now();
+  double t_parallel = std::chrono::duration<double>(t1 - t0).count();
+
+  double max_diff = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        max_diff = fmax(max_diff, fabs(m->get_value(i, j, k) -
+                                       m_sweep.get_value(i, j, k)));
+        max_diff = fmax(max_diff, fabs(m->get_value(i, j, k) -
+                                       m_parallel.get_value(i, j, k)));
+      }
+    }
+  }
+
+  std::cout << "march: " << t_march << "s, "
+            << "sweep: " << t_sweep << "s (" << num_sweeps << " sweeps), "
+            << "parallel sweep: " << t_parallel << "s "
+            << "(" << m_parallel.get_num_threads() << " threads, "
+            << m_parallel.get_num_rounds() << " rounds), "
+            << "max |u_march - u_sweep|: " << max_diff << std::endl;
+
+  delete m;
+}
+
+void compare_sweeping(std::string const & marcher_name, int n) {
+  if (marcher_name == "olim6_mp0") compare_sweeping<olim6_mp0>(n);
+  if (marcher_name == "olim6_mp1") compare_sweeping<olim6_mp1>(n);
+  if (marcher_name == "olim6_rhr") compare_sweeping<olim6_rhr>(n);
+  if (marcher_name == "olim18_mp0") compare_sweeping<olim18_mp0>(n);
+  if (marcher_name == "olim18_mp1") compare_sweeping<olim18_mp1>(n);
+  if (marcher_name == "olim18_rhr") compare_sweeping<olim18_rhr>(n);
+  if (marcher_name == "olim26_mp0") compare_sweeping<olim26_mp0>(n);
+  if (marcher_name == "olim26_mp1") compare_sweeping<olim26_mp1>(n);
+  if (marcher_name == "olim26_rhr") compare_sweeping<olim26_rhr>(n);
+  if (marcher_name == "olim3d_hu_mp0") compare_sweeping<olim3d_hu_mp0>(n);
+  if (marcher_name == "olim3d_hu_mp1") compare_sweeping<olim3d_hu_mp1>(n);
+  if (marcher_name == "olim3d_hu_rhr") compare_sweeping<olim3d_hu_rhr>(n);
+}
+
+int main(int argc, char * argv[]) {
+  if (argc != 4) {
+    std::cout << "usage: " << argv[0] << " marcher queue N" << std::endl
+              << std::endl
+              << "where queue is one of: bucket, heap4, heap8, lazy4" << std::endl
+              << "(or use `float' in place of the queue to compare the" << std::endl
+              << "marcher with its single precision version, or" << std::endl
+              << "`virtual' to compare running it through the" << std::endl
+              << "abstract_marcher interface with running it directly," << std::endl
+              << "`tris_first' to compare it with the version that" << std::endl
+              << "does the triangle updates first, `many' to time" << std::endl
+              << "constructing and running lots of small marchers," << std::endl
+              << "`parallel' to compare it with parallel_marcher_3d, or" << std::endl
+              << "`sweep' to compare it with fast sweeping)"
+              << std::endl;
+    std::exit(1);
+  }
+
+  std::string marcher_name {argv[1]};
+  std::string queue_name {argv[2]};
+  int n = std::stoi(argv[3]);
+
+  if (queue_name == "bucket") compare_queues<bucket_queue>(marcher_name, n);
+  if (queue_name == "heap4") compare_queues<heap4>(marcher_name, n);
+  if (queue_name == "heap8") compare_queues<heap8>(marcher_name, n);
+  if (queue_name == "lazy4") compare_queues<lazy_heap4>(marcher_name, n);
+  if (queue_name == "float") compare_precisions(marcher_name, n);
+  if (queue_name == "virtual") compare_dispatch(marcher_name, n);
+  if (queue_name == "tris_first") compare_tetra_strategies(marcher_name, n);
+  if (queue_name == "many") time_many_small(marcher_name, n);
+  if (queue_name == "parallel") compare_parallel(marcher_name, n);
+  if (queue_name == "sweep") compare_sweeping(marcher_name, n);
+}
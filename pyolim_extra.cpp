@@ -6,7 +6,8 @@
 py::enum_<state>(m, "State")
   .value("Valid", state::valid)
   .value("Trial", state::trial)
-  .value("Far", state::far);
+  .value("Far", state::far)
+  .value("Barrier", state::barrier);
 
 // We could probably clean this up a little by exposing the
 // abstract_node base class here.
@@ -29,6 +30,24 @@ py::class_<node_3d>(m, "Node3d")
 #endif
   ;
 
+py::class_<compact_node_3d>(m, "CompactNode3d")
+  .def_property("value", &compact_node_3d::get_value,
+                &compact_node_3d::set_value)
+  .def_property("state", &compact_node_3d::get_state,
+                &compact_node_3d::set_state)
+  .def_property_readonly("i", &compact_node_3d::get_i)
+  .def_property_readonly("j", &compact_node_3d::get_j)
+  .def_property_readonly("k", &compact_node_3d::get_k);
+
+py::class_<compact_float_node_3d>(m, "CompactFloatNode3d")
+  .def_property("value", &compact_float_node_3d::get_value,
+                &compact_float_node_3d::set_value)
+  .def_property("state", &compact_float_node_3d::get_state,
+                &compact_float_node_3d::set_state)
+  .def_property_readonly("i", &compact_float_node_3d::get_i)
+  .def_property_readonly("j", &compact_float_node_3d::get_j)
+  .def_property_readonly("k", &compact_float_node_3d::get_k);
+
 py::class_<node::fac_center>(m, "FacCenter")
   .def(py::init<double, double, double>())
   .def_readwrite("i", &node::fac_center::i)
@@ -4,21 +4,41 @@
 #include "heap.hpp"
 #include "abstract_node.hpp"
 
+/**
+ * The priority queue used to order trial nodes is a policy: `queue'
+ * is a class template taking the node type which must provide
+ * `front', `pop_front', `insert', `swim' (called after a trial node's
+ * value has decreased), `empty', `size' and `reserve' with the same
+ * meaning as they have for `heap'. See bucket_queue.hpp, dary_heap.hpp
+ * and lazy_heap.hpp for alternatives to the default binary heap.
+ */
+template <class node, template <class> class queue>
 struct abstract_marcher {
   void run();
   void step();
+  void reserve_heap(size_t capacity);
   virtual ~abstract_marcher() {}
 EIKONAL_PROTECTED:
   abstract_marcher(size_t initial_heap_size = 256ul);
-  void visit_neighbors(abstract_node * n);
-  abstract_node * get_next_node();
-  void adjust_heap_entry(abstract_node * n);
-  void insert_into_heap(abstract_node * n);
+  void visit_neighbors(node * n);
+  node * get_next_node();
+  void adjust_heap_entry(node * n);
+  void insert_into_heap(node * n);
 
-  heap<abstract_node> _heap;
+  queue<node> _heap;
 EIKONAL_PRIVATE:
-  // TODO: we could remove this virtual call with CRTP.
-  virtual void visit_neighbors_impl(abstract_node * n) = 0;
+  // This is responsible for marking `n' as valid (where node states
+  // are kept depends on the marcher).
+  //
+  // Calling `run' or `step' through an abstract_marcher goes through
+  // this virtual call (and the virtual `update_impl' of the
+  // marcher). marcher and marcher_3d hide `run' and `step' with
+  // versions which dispatch statically, so that the whole marching
+  // loop is instantiated (and can be inlined) for each concrete
+  // marcher.
+  virtual void visit_neighbors_impl(node * n) = 0;
 };
 
+#include "abstract_marcher.impl.hpp"
+
 #endif // __ABSTRACT_MARCHER_HPP__
@@ -0,0 +1,58 @@
+#ifndef __ABSTRACT_MARCHER_IMPL_HPP__
+#define __ABSTRACT_MARCHER_IMPL_HPP__
+
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::run() {
+  node * n {nullptr};
+  while (!_heap.empty()) {
+    n = get_next_node();
+    visit_neighbors(n);
+  }
+}
+
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::step() {
+  auto * n = get_next_node();
+  visit_neighbors(n);
+}
+
+/**
+ * Make sure the heap can hold at least `capacity' nodes without
+ * reallocating. The marchers size the heap using the surface area of
+ * the grid, which is a good estimate of the size of the front
+ * for a point source, but this can be used to pass a better estimate
+ * (e.g. for a large or complicated set of boundary nodes).
+ */
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::reserve_heap(size_t capacity) {
+  _heap.reserve(capacity);
+}
+
+template <class node, template <class> class queue>
+abstract_marcher<node, queue>::abstract_marcher(size_t initial_heap_size):
+  _heap {initial_heap_size}
+{}
+
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::visit_neighbors(node * n) {
+  visit_neighbors_impl(n);
+}
+
+template <class node, template <class> class queue>
+node * abstract_marcher<node, queue>::get_next_node() {
+  auto const n = _heap.front();
+  _heap.pop_front();
+  return n;
+}
+
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::adjust_heap_entry(node * n) {
+  _heap.swim(n);
+}
+
+template <class node, template <class> class queue>
+void abstract_marcher<node, queue>::insert_into_heap(node * n) {
+  _heap.insert(n);
+}
+
+#endif // __ABSTRACT_MARCHER_IMPL_HPP__
@@ -11,7 +11,9 @@
 
 #include "common.hpp"
 
-enum class state {valid, trial, far};
+// Nodes in the `barrier' state are never updated or used to update
+// other nodes: they're used to pad the grid (see marcher_3d::init).
+enum class state: char {valid, trial, far, barrier};
 
 inline
 std::string
@@ -19,10 +21,16 @@ to_string(state const & s)
 {
   if (s == state::valid) return "valid";
   else if (s == state::trial) return "trial";
-  else return "far";
+  else if (s == state::far) return "far";
+  else return "barrier";
 }
 
 struct abstract_node {
+  // See soa_node_3d.hpp and compact_node_3d.hpp.
+  using float_type = double;
+  static constexpr bool is_soa = false;
+  static constexpr bool has_fac_index = false;
+
   abstract_node() {}
   abstract_node(double value, state s): _value {value}, _state {s} {}
   inline double get_value() const { return _value; }
@@ -17,6 +17,8 @@ struct basic_marcher: public marcher<basic_marcher, node, 4>,
   node * nb[num_neighbors];
 
 EIKONAL_PRIVATE:
+  friend struct marcher<basic_marcher, node, num_neighbors>;
+
   virtual void update_impl(node * n, double & T);
 };
 
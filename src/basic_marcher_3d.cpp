@@ -17,12 +17,12 @@
 #define COMPUTE_VALUE_3PT() ((T1 + T2 + T3 + sqrt(disc))/3)
 
 void basic_marcher_3d::update_impl(
-  node_3d * n, node_3d ** nb, int parent, double & T)
+  int i, int j, int k, node_3d ** nb, uint32_t nb_mask, int parent,
+  double & T)
 {
+  (void) nb_mask;
   (void) parent;
 
-  int i = n->get_i(), j = n->get_j(), k = n->get_k();
-
   double sh = get_h()*get_speed(i, j, k), sh_sq = sh*sh;
   double T1 = 0, T2 = 0, T3 = 0, disc = 0;
 
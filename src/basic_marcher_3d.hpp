@@ -17,7 +17,11 @@ struct basic_marcher_3d: public marcher_3d<basic_marcher_3d, node_3d, 6>,
   node_3d * nb[num_neighbors];
 
 EIKONAL_PRIVATE:
-  virtual void update_impl(node_3d * n, node_3d ** nb, int parent, double & T);
+  friend struct marcher_3d<basic_marcher_3d, node_3d, num_neighbors>;
+
+  virtual void update_impl(
+    int i, int j, int k, node_3d ** nb, uint32_t nb_mask, int parent,
+    double & T);
 };
 
 #endif // __BASIC_MARCHER_3D_HPP__
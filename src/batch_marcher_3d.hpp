@@ -0,0 +1,64 @@
+#ifndef __BATCH_MARCHER_3D_HPP__
+#define __BATCH_MARCHER_3D_HPP__
+
+#include <memory>
+#include <vector>
+
+#include "common.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Solve the eikonal equation for many different sets of boundary
+ * nodes using the same speed function cache, running independent
+ * copies of `olim' (any of the 3D marchers) concurrently on a
+ * thread_pool.
+ *
+ * The speed function cache is borrowed, not copied (see the
+ * marcher_3d constructor taking a shared_ptr), and is shared by all
+ * of the marchers. There's one marcher per thread, which is reset
+ * and reused for each solve, so the memory used doesn't depend on
+ * the number of solves: it's one marcher's node array (and heap) per
+ * thread, plus the output.
+ */
+template <class olim>
+struct batch_marcher_3d
+{
+  // See marcher_3d::add_boundary_node.
+  struct boundary_node {
+    int i, j, k;
+    double value;
+  };
+
+  // `s_cache' is laid out column-major, and has to outlive calls to
+  // `run'. (If marcher_3d's layout is tiled, each marcher makes its
+  // own reordered copy of it.)
+  batch_marcher_3d(int height, int width, int depth, double h,
+                   double const * s_cache, int num_threads = 0);
+
+  // Solve once for each set of boundary nodes in `sources', and write
+  // the solution for sources[l] to out + l*height*width*depth (laid
+  // out like s_cache).
+  void run(std::vector<std::vector<boundary_node>> const & sources,
+           double * out);
+
+  int get_height() const { return _height; }
+  int get_width() const { return _width; }
+  int get_depth() const { return _depth; }
+  int get_num_threads() const { return _pool.size(); }
+
+EIKONAL_PRIVATE:
+  void solve(olim & m, std::vector<boundary_node> const & nodes,
+             double * out) const;
+
+  int _height, _width, _depth;
+  double _h;
+  std::shared_ptr<double const> _s_cache;
+  thread_pool _pool;
+
+  // One marcher per thread, created the first time it's needed.
+  std::vector<std::unique_ptr<olim>> _marchers;
+};
+
+#include "batch_marcher_3d.impl.hpp"
+
+#endif // __BATCH_MARCHER_3D_HPP__
@@ -0,0 +1,64 @@
+#ifndef __BATCH_MARCHER_3D_IMPL_HPP__
+#define __BATCH_MARCHER_3D_IMPL_HPP__
+
+#include <assert.h>
+
+#include <atomic>
+
+template <class olim>
+batch_marcher_3d<olim>::batch_marcher_3d(
+  int height, int width, int depth, double h, double const * s_cache,
+  int num_threads):
+  _height {height},
+  _width {width},
+  _depth {depth},
+  _h {h},
+  // The caller owns s_cache, so the marchers don't need to keep it
+  // alive (hence the empty deleter).
+  _s_cache {s_cache, [] (double const *) {}},
+  _pool {num_threads},
+  _marchers(_pool.size())
+{
+  assert(s_cache != nullptr);
+}
+
+template <class olim>
+void
+batch_marcher_3d<olim>::run(
+  std::vector<std::vector<boundary_node>> const & sources, double * out)
+{
+  int num_sources = static_cast<int>(sources.size());
+  long size = static_cast<long>(_height)*_width*_depth;
+
+  // Each of the pool's threads takes its own marcher and then takes
+  // sources one at a time until they're all done, so that at most one
+  // thread uses each marcher.
+  std::atomic<int> next {0};
+  _pool.parallel_for(_pool.size(), [&] (int t) {
+    for (int l = next++; l < num_sources; l = next++) {
+      if (!_marchers[t]) {
+        _marchers[t] = std::make_unique<olim>(
+          _height, _width, _depth, _h, _s_cache);
+      }
+      solve(*_marchers[t], sources[l], out + l*size);
+    }
+  });
+}
+
+template <class olim>
+void
+batch_marcher_3d<olim>::solve(
+  olim & m, std::vector<boundary_node> const & nodes, double * out) const
+{
+  m.reset();
+  for (auto const & n: nodes) {
+    assert(0 <= n.i && n.i < _height);
+    assert(0 <= n.j && n.j < _width);
+    assert(0 <= n.k && n.k < _depth);
+    m.add_boundary_node(n.i, n.j, n.k, n.value);
+  }
+  m.run();
+  m.copy_values(out);
+}
+
+#endif // __BATCH_MARCHER_3D_IMPL_HPP__
@@ -0,0 +1,308 @@
+#ifndef __BUCKET_QUEUE_HPP__
+#define __BUCKET_QUEUE_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.hpp"
+
+/**
+ * An "untidy" bucketed priority queue in the style of Dial's
+ * algorithm (see Yatziv, Bartesaghi & Sapiro, "O(N) implementation of
+ * the fast marching algorithm", 2006). A node with value T is placed
+ * in bucket floor(T/w), where w is the bucket width, and nodes in the
+ * same bucket are popped in FIFO order. Insertions and pops are
+ * amortized O(1).
+ *
+ * The marchers key the queue on T/(s_min*h) (see `set_key_scale'
+ * below), and each unit of that key is split into `subdivisions'
+ * buckets, so w = s_min*h/subdivisions. Each node which is accepted
+ * has a value which is within w of the smallest trial value at the
+ * time it's accepted; this is the only sense in which the ordering
+ * differs from the one produced by `heap'. Accepting a node slightly
+ * out of order can freeze it before its final update, so the
+ * solution differs from the heap-ordered solution by O(w). For the
+ * default speed function, olim6_rhr with n = 101 differs by about
+ * 3e-2 with one bucket per unit, 9e-4 with eight, and 6e-5 with
+ * sixteen; the 18 and 26 point olims agree to within rounding error
+ * with eight.
+ *
+ * Instead of tracking each node's position, decreasing a node's value
+ * just pushes a new entry, and the old entry is discarded when it's
+ * reached if the node is no longer trial or its value has
+ * changed. Because of this, the node's heap position isn't used.
+ * Nodes inserted with an infinite value (which is what happens when
+ * the marchers stage far nodes) are kept in a separate overflow
+ * bucket which is only looked at once the finite buckets are empty.
+ */
+template <class Node>
+struct bucket_queue
+{
+  static constexpr int subdivisions = 8;
+
+  bucket_queue(size_t capacity);
+  ~bucket_queue();
+
+  Node * front();
+  bool empty() const;
+  size_t size() const;
+  void pop_front();
+  void insert(Node * n);
+  void swim(Node * n);
+  void reserve(size_t capacity);
+
+  double get_bucket_width() const { return _width; }
+  void set_bucket_width(double width);
+
+EIKONAL_PRIVATE:
+  struct entry {
+    Node * node;
+    double key;
+  };
+
+  struct bucket {
+    entry * data {nullptr};
+    size_t head {0}, tail {0}, capacity {0};
+  };
+
+  bucket & get_bucket(int64_t b) { return _buckets[b & (_num_buckets - 1)]; }
+  bucket & get_front_bucket() {
+    return _num_entries == 0 ? _overflow : get_bucket(_first);
+  }
+  void push(Node * n);
+  void skip_stale_entries();
+  void grow_buckets(int64_t first, int64_t last);
+  void grow_bucket(bucket & b);
+  void compact_overflow();
+
+  bucket * _buckets {nullptr};
+  bucket _overflow;
+  int64_t _num_buckets {0};
+  int64_t _first {0}, _last {0};
+  size_t _capacity {0};
+  size_t _size {0};
+  size_t _num_entries {0};
+  double _width {1};
+};
+
+template <class Node>
+bucket_queue<Node>::bucket_queue(size_t capacity):
+  _buckets {new bucket[16]},
+  _num_buckets {16}
+{
+  reserve(capacity);
+}
+
+template <class Node>
+bucket_queue<Node>::~bucket_queue() {
+  for (int64_t b = 0; b < _num_buckets; ++b) {
+    delete[] _buckets[b].data;
+  }
+  delete[] _buckets;
+  delete[] _overflow.data;
+}
+
+template <class Node>
+Node * bucket_queue<Node>::front() {
+  assert(_size > 0);
+  skip_stale_entries();
+  auto const & b = get_front_bucket();
+  return b.data[b.head].node;
+}
+
+template <class Node>
+bool bucket_queue<Node>::empty() const {
+  return _size == 0;
+}
+
+template <class Node>
+size_t bucket_queue<Node>::size() const {
+  return _size;
+}
+
+template <class Node>
+void bucket_queue<Node>::pop_front() {
+  assert(_size > 0);
+  skip_stale_entries();
+  auto & b = get_front_bucket();
+  if (&b != &_overflow) {
+    --_num_entries;
+  }
+  if (++b.head == b.tail) {
+    b.head = b.tail = 0;
+  }
+  --_size;
+}
+
+template <class Node>
+void bucket_queue<Node>::insert(Node * n) {
+  push(n);
+  ++_size;
+}
+
+template <class Node>
+void bucket_queue<Node>::swim(Node * n) {
+  push(n);
+}
+
+template <class Node>
+void bucket_queue<Node>::reserve(size_t capacity) {
+  // `capacity' is the total number of entries we expect to hold at
+  // once. Only a few buckets are in use at a time, so we size newly
+  // allocated buckets as though the entries were spread over the
+  // current number of buckets.
+  size_t bucket_capacity = capacity/_num_buckets;
+  if (bucket_capacity > _capacity) {
+    _capacity = bucket_capacity;
+  }
+  if (_capacity < 4) {
+    _capacity = 4;
+  }
+}
+
+template <class Node>
+void bucket_queue<Node>::set_bucket_width(double width) {
+  assert(width > 0);
+  assert(_size == 0);
+  _width = width;
+}
+
+template <class Node>
+void bucket_queue<Node>::push(Node * n) {
+  double key = n->get_value();
+  if (isinf(key)) {
+    if (_overflow.tail == _overflow.capacity) {
+      compact_overflow();
+    }
+    _overflow.data[_overflow.tail++] = {n, key};
+    return;
+  }
+  int64_t b = static_cast<int64_t>(floor(key/_width));
+  if (_num_entries == 0) {
+    _first = _last = b;
+  } else if (b < _first) {
+    if (_last - b >= _num_buckets) {
+      grow_buckets(b, _last);
+    }
+    _first = b;
+  } else if (b > _last) {
+    if (b - _first >= _num_buckets) {
+      grow_buckets(_first, b);
+    }
+    _last = b;
+  }
+  auto & bucket = get_bucket(b);
+  if (bucket.tail == bucket.capacity) {
+    grow_bucket(bucket);
+  }
+  bucket.data[bucket.tail++] = {n, key};
+  ++_num_entries;
+}
+
+template <class Node>
+void bucket_queue<Node>::skip_stale_entries() {
+  // An entry is stale if its node has already been accepted, or if
+  // the node's value was lowered after the entry was pushed (in which
+  // case a newer entry for the node exists).
+  while (_num_entries > 0) {
+    auto & b = get_bucket(_first);
+    while (b.head < b.tail) {
+      auto const & e = b.data[b.head];
+      if (e.node->is_trial() && e.node->get_value() == e.key) {
+        return;
+      }
+      ++b.head;
+      --_num_entries;
+    }
+    b.head = b.tail = 0;
+    if (_num_entries > 0) {
+      ++_first;
+    }
+  }
+  while (_overflow.head < _overflow.tail) {
+    auto const & e = _overflow.data[_overflow.head];
+    if (e.node->is_trial() && isinf(e.node->get_value())) {
+      return;
+    }
+    ++_overflow.head;
+  }
+  assert(false);
+}
+
+template <class Node>
+void bucket_queue<Node>::grow_buckets(int64_t first, int64_t last) {
+  // The ring is indexed using the absolute bucket index modulo the
+  // number of buckets, so every bucket (including empty buckets,
+  // whose storage we want to keep) needs to be moved to a new slot.
+  int64_t num_buckets = _num_buckets;
+  while (last - first >= num_buckets) {
+    num_buckets *= 2;
+  }
+  bucket * tmp = new bucket[num_buckets];
+  for (int64_t c = _first; c < _first + _num_buckets; ++c) {
+    tmp[c & (num_buckets - 1)] = get_bucket(c);
+  }
+  delete[] _buckets;
+  _buckets = tmp;
+  _num_buckets = num_buckets;
+}
+
+template <class Node>
+void bucket_queue<Node>::grow_bucket(bucket & b) {
+  // Compact the bucket before deciding whether we actually need to
+  // reallocate it.
+  if (b.head > 0) {
+    memmove(b.data, b.data + b.head, (b.tail - b.head)*sizeof(entry));
+    b.tail -= b.head;
+    b.head = 0;
+    if (b.tail < b.capacity) {
+      return;
+    }
+  }
+  size_t capacity = b.capacity == 0 ? _capacity : 2*b.capacity;
+  entry * tmp = new entry[capacity];
+  if (b.data != nullptr) {
+    memcpy(tmp, b.data, b.tail*sizeof(entry));
+    delete[] b.data;
+  }
+  b.data = tmp;
+  b.capacity = capacity;
+}
+
+template <class Node>
+void bucket_queue<Node>::compact_overflow() {
+  // Almost every node in the overflow bucket has its value lowered
+  // immediately after being inserted, so rather than growing it, try
+  // throwing away its stale entries first.
+  size_t tail = 0;
+  for (size_t i = _overflow.head; i < _overflow.tail; ++i) {
+    auto const & e = _overflow.data[i];
+    if (e.node->is_trial() && isinf(e.node->get_value())) {
+      _overflow.data[tail++] = e;
+    }
+  }
+  _overflow.head = 0;
+  _overflow.tail = tail;
+  if (2*_overflow.tail >= _overflow.capacity) {
+    grow_bucket(_overflow);
+  }
+}
+
+/**
+ * The marchers call `set_key_scale' with s_min*h before inserting any
+ * nodes. Only the bucketed queue needs to know about this scale.
+ */
+template <class queue>
+inline void set_key_scale(queue &, double) {}
+
+template <class Node>
+inline void set_key_scale(bucket_queue<Node> & q, double scale) {
+  q.set_bucket_width(scale/bucket_queue<Node>::subdivisions);
+}
+
+#endif // __BUCKET_QUEUE_HPP__
@@ -2,6 +2,7 @@
 #define __COMMON_DEFS_HPP__
 
 // TODO: try to remove these
+#include <cstdint>
 #include <limits>
 #include <type_traits>
 
@@ -19,6 +20,18 @@ constexpr T eps = std::numeric_limits<T>::epsilon();
 template <class T>
 constexpr T inf = std::numeric_limits<T>::infinity();
 
+// The index of the lowest set bit of x, which must be nonzero. This
+// is used to loop over the set bits of a mask, from lowest to highest.
+inline int ctz(uint32_t x) {
+#if defined(__GNUC__)
+  return __builtin_ctz(x);
+#else
+  int i = 0;
+  while (!((x >> i) & 1)) ++i;
+  return i;
+#endif
+}
+
 #ifdef EIKONAL_DEBUG
 #  define EIKONAL_PROTECTED public
 #  define EIKONAL_PRIVATE public
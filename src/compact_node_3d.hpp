@@ -0,0 +1,100 @@
+#ifndef __COMPACT_NODE_3D_HPP__
+#define __COMPACT_NODE_3D_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "node_3d.hpp"
+
+/**
+ * A smaller version of node_3d (see item 2 of the optimization list
+ * in todo.org): the indices are stored as int16_t's (so each
+ * dimension of the grid has to be less than 2^15), the state is a
+ * char, and instead of a pointer to its factoring center, the node
+ * stores a 32-bit index into a table of factoring centers kept by the
+ * marcher (index 0 means the node isn't factored). This packs the
+ * node into 24 bytes instead of 40.
+ *
+ * The value can also be stored in single precision (see
+ * compact_float_node_3d below), which brings the node down to 20
+ * bytes, and also makes the marcher store its speed function cache in
+ * single precision.
+ *
+ * The value comes first so that the node array can be exposed as a
+ * strided array of values (see generate_pyolim_cpp.py).
+ */
+template <class T>
+struct basic_compact_node_3d {
+  using fac_center = node_3d::fac_center;
+  using float_type = T;
+
+  static constexpr bool is_soa = false;
+  static constexpr bool has_fac_index = true;
+
+  basic_compact_node_3d() {}
+  basic_compact_node_3d(int i, int j, int k, double value = 0,
+                        state s = state::valid):
+    _value {static_cast<T>(value)},
+    _i {static_cast<int16_t>(i)},
+    _j {static_cast<int16_t>(j)},
+    _k {static_cast<int16_t>(k)},
+    _state {s}
+  {
+    assert(i <= INT16_MAX && j <= INT16_MAX && k <= INT16_MAX);
+  }
+
+  inline double get_value() const { return _value; }
+  inline void set_value(double value) { _value = static_cast<T>(value); }
+  inline int get_heap_pos() const { return _heap_pos; }
+  inline void set_heap_pos(int pos) { _heap_pos = pos; }
+  inline state get_state() const { return _state; }
+  inline void set_state(state s) { _state = s; }
+  inline bool is_valid() const { return _state == state::valid; }
+  inline bool is_trial() const { return _state == state::trial; }
+  inline bool is_far() const { return _state == state::far; }
+  inline void set_valid() { _state = state::valid; }
+  inline void set_trial() { _state = state::trial; }
+  inline void set_far() { _state = state::far; }
+
+  inline int get_i() const { return _i; }
+  inline void set_i(int i) { _i = static_cast<int16_t>(i); }
+  inline int get_j() const { return _j; }
+  inline void set_j(int j) { _j = static_cast<int16_t>(j); }
+  inline int get_k() const { return _k; }
+  inline void set_k(int k) { _k = static_cast<int16_t>(k); }
+
+  inline bool is_factored() const { return _fac_index != 0; }
+  inline uint32_t get_fac_index() const { return _fac_index; }
+  inline void set_fac_index(uint32_t index) { _fac_index = index; }
+
+EIKONAL_PRIVATE:
+  T _value {std::numeric_limits<T>::infinity()};
+  int _heap_pos {-1};
+  uint32_t _fac_index {0};
+  int16_t _i {-1}, _j {-1}, _k {-1};
+  state _state {state::far};
+};
+
+using compact_node_3d = basic_compact_node_3d<double>;
+using compact_float_node_3d = basic_compact_node_3d<float>;
+
+static_assert(sizeof(compact_node_3d) == 24,
+              "compact_node_3d should be packed into 24 bytes");
+static_assert(sizeof(compact_float_node_3d) == 20,
+              "compact_float_node_3d should be packed into 20 bytes");
+
+template <class T>
+inline
+std::ostream &
+operator<<(std::ostream & o, basic_compact_node_3d<T> const & n)
+{
+  o.precision(std::numeric_limits<double>::max_digits10);
+  return o << "compact_node_3d {value = " << n.get_value() << ", "
+           << "state = " << to_string(n.get_state()) << ", "
+           << "(" << n.get_i() << ", " << n.get_j() << ", " << n.get_k()
+           << ")}";
+}
+
+#endif // __COMPACT_NODE_3D_HPP__
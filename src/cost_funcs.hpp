@@ -305,7 +305,8 @@ void set_lambda(F_wkspc<F, 2> & w, double const * lam)
 #undef __dPt_dP
 
 template <cost_func F>
-void set_lambda(F_wkspc<F, 2> & w, geom_wkspc<2> & g, double const * lam)
+void set_lambda(F_wkspc<F, 2> & w, geom_wkspc<2> const & g,
+                double const * lam)
 {
   check_lambda<2>(lam);
 
@@ -577,13 +578,13 @@ struct cost_functor_bv<F, n, p0, p1, p2>
 template <cost_func F, int n, int d>
 struct cost_functor
 {
-  cost_functor(F_wkspc<F, d> & w, geom_wkspc<d> & g): w {w}, g {g} {}
+  cost_functor(F_wkspc<F, d> & w, geom_wkspc<d> const & g): w {w}, g {g} {}
   inline void set_lambda(double const * lam) {::set_lambda<F>(w, g, lam);}
   inline void eval(double & f) const {::eval(w, f);}
   inline void grad(double * df) const  {::grad(w, df);}
   inline void hess(double * d2f) const {::hess(w, g, d2f);}
   F_wkspc<F, d> & w;
-  geom_wkspc<d> & g;
+  geom_wkspc<d> const & g;
   qr_wkspc<n, d> const * qr {nullptr};
 };
 
@@ -0,0 +1,236 @@
+#ifndef __DARY_HEAP_HPP__
+#define __DARY_HEAP_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.hpp"
+
+/**
+ * A d-ary min-heap which stores each node's key inline, next to the
+ * node's linear index in the marcher's node array, instead of storing
+ * pointers to the nodes. Comparisons during `swim' and `sink' only
+ * touch the heap's own array, rather than dereferencing a pointer into
+ * the node grid, and the heap position of each node is kept in a
+ * separate array owned by the heap (so `abstract_node::set_heap_pos'
+ * is never called).
+ *
+ * The entries are 16 bytes and the array is offset so that the d
+ * children of each entry start on a 64-byte boundary: for d = 4, each
+ * `sink' step reads exactly one cache line.
+ *
+ * Before inserting any nodes, the heap has to be told where the
+ * node array is using `set_nodes' (see `set_node_array' below, which
+ * the marchers call).
+ */
+template <class Node, int d>
+struct dary_heap
+{
+  static_assert(d >= 2, "d must be at least 2");
+
+  dary_heap(size_t capacity);
+  ~dary_heap();
+
+  Node * front() const;
+  bool empty() const;
+  size_t size() const;
+  void pop_front();
+  void insert(Node * n);
+  void swim(Node * n);
+  void reserve(size_t capacity);
+
+  void set_nodes(Node * nodes, size_t num_nodes);
+
+EIKONAL_PRIVATE:
+  static constexpr size_t arity = d;
+
+  struct entry {
+    double key;
+    uint32_t index;
+  };
+
+  void grow();
+  void realloc(size_t capacity);
+  void swim(size_t pos, entry e);
+  void sink(size_t pos, entry e);
+  void set(size_t pos, entry e) {
+    _data[pos] = e;
+    _pos[e.index] = static_cast<uint32_t>(pos);
+  }
+  bool has_heap_prop() const;
+
+  entry * _alloc {nullptr};
+  entry * _data {nullptr};
+  uint32_t * _pos {nullptr};
+  Node * _nodes {nullptr};
+  size_t _num_nodes {0};
+  size_t _size {0};
+  size_t _capacity {0};
+};
+
+template <class Node> using heap4 = dary_heap<Node, 4>;
+template <class Node> using heap8 = dary_heap<Node, 8>;
+
+template <class Node, int d>
+dary_heap<Node, d>::dary_heap(size_t capacity) {
+  realloc(capacity < arity ? arity : capacity);
+}
+
+template <class Node, int d>
+dary_heap<Node, d>::~dary_heap() {
+  free(_alloc);
+  delete[] _pos;
+}
+
+template <class Node, int d>
+Node * dary_heap<Node, d>::front() const {
+  assert(_size > 0);
+  return _nodes + _data[0].index;
+}
+
+template <class Node, int d>
+bool dary_heap<Node, d>::empty() const {
+  return _size == 0;
+}
+
+template <class Node, int d>
+size_t dary_heap<Node, d>::size() const {
+  return _size;
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::pop_front() {
+  assert(_size > 0);
+  if (--_size > 0) {
+    sink(0, _data[_size]);
+  }
+#if CHECK_HEAP_PROP_IN_DEBUG && EIKONAL_DEBUG && !RELWITHDEBINFO
+  assert(has_heap_prop());
+#endif
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::insert(Node * n) {
+  assert(_nodes != nullptr);
+  assert(static_cast<size_t>(n - _nodes) < _num_nodes);
+  if (_size == _capacity) grow();
+  entry e {n->get_value(), static_cast<uint32_t>(n - _nodes)};
+  swim(_size++, e);
+#if CHECK_HEAP_PROP_IN_DEBUG && EIKONAL_DEBUG && !RELWITHDEBINFO
+  assert(has_heap_prop());
+#endif
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::swim(Node * n) {
+  uint32_t index = static_cast<uint32_t>(n - _nodes);
+  size_t pos = _pos[index];
+  assert(pos < _size && _data[pos].index == index);
+  assert(n->get_value() <= _data[pos].key);
+  swim(pos, {n->get_value(), index});
+#if CHECK_HEAP_PROP_IN_DEBUG && EIKONAL_DEBUG && !RELWITHDEBINFO
+  assert(has_heap_prop());
+#endif
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::set_nodes(Node * nodes, size_t num_nodes) {
+  assert(_size == 0);
+  assert(num_nodes <= UINT32_MAX);
+  delete[] _pos;
+  _nodes = nodes;
+  _num_nodes = num_nodes;
+  _pos = new uint32_t[num_nodes];
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::reserve(size_t capacity) {
+  if (capacity > _capacity) {
+    realloc(capacity);
+  }
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::grow() {
+  realloc(2*_capacity);
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::realloc(size_t capacity) {
+  // Leave d - 1 unused entries in front of the root so that the
+  // children of each entry are aligned (the children of position p
+  // are d*p + 1, ..., d*p + d).
+  entry * alloc = static_cast<entry *>(
+    aligned_alloc(64, (((capacity + d - 1)*sizeof(entry) + 63)/64)*64));
+  if (_alloc != nullptr) {
+    memcpy(alloc + d - 1, _data, _size*sizeof(entry));
+    free(_alloc);
+  }
+  _alloc = alloc;
+  _data = alloc + d - 1;
+  _capacity = capacity;
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::swim(size_t pos, entry e) {
+  // Move parents down into the hole instead of swapping, and write e
+  // once at the end.
+  while (pos > 0) {
+    size_t parent = (pos - 1)/arity;
+    if (_data[parent].key <= e.key) {
+      break;
+    }
+    set(pos, _data[parent]);
+    pos = parent;
+  }
+  set(pos, e);
+}
+
+template <class Node, int d>
+void dary_heap<Node, d>::sink(size_t pos, entry e) {
+  size_t ch;
+  while ((ch = arity*pos + 1) < _size) {
+    size_t end = ch + arity < _size ? ch + arity : _size, min = ch;
+    for (size_t c = ch + 1; c < end; ++c) {
+      if (_data[c].key < _data[min].key) {
+        min = c;
+      }
+    }
+    if (e.key <= _data[min].key) {
+      break;
+    }
+    set(pos, _data[min]);
+    pos = min;
+  }
+  set(pos, e);
+}
+
+template <class Node, int d>
+bool dary_heap<Node, d>::has_heap_prop() const {
+  for (size_t pos = 1; pos < _size; ++pos) {
+    if (_data[(pos - 1)/arity].key > _data[pos].key ||
+        _pos[_data[pos].index] != pos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * The marchers call `set_node_array' with their node array once it's
+ * been allocated. Only queues which refer to nodes by index need it.
+ */
+template <class queue, class Node>
+inline void set_node_array(queue &, Node *, size_t) {}
+
+template <class Node, int d>
+inline void set_node_array(dary_heap<Node, d> & q, Node * nodes, size_t n) {
+  q.set_nodes(nodes, n);
+}
+
+#endif // __DARY_HEAP_HPP__
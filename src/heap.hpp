@@ -23,12 +23,15 @@ struct heap
   bool empty() const;
   Node ** data() const;
   size_t size() const;
+  size_t capacity() const;
   void pop_front();
   void insert(Node * n);
   void swim(Node * n);
+  void reserve(size_t capacity);
   void print() const;
 EIKONAL_PRIVATE:
   void grow();
+  void realloc(size_t capacity);
   void swim(int pos);
   void sink(int pos);
   bool has_heap_prop() const;
@@ -83,6 +86,11 @@ size_t heap<Node>::size() const {
   return _size;
 }
 
+template <class Node>
+size_t heap<Node>::capacity() const {
+  return _capacity;
+}
+
 template <class Node>
 void heap<Node>::pop_front() {
   swap(0, _size - 1);
@@ -161,9 +169,21 @@ void heap<Node>::print() const {
   std::cout << std::endl;
 }
 
+template <class Node>
+void heap<Node>::reserve(size_t capacity) {
+  if (capacity > _capacity) {
+    realloc(capacity);
+  }
+}
+
 template <class Node>
 void heap<Node>::grow() {
-  _capacity *= 2;
+  realloc(2*_capacity);
+}
+
+template <class Node>
+void heap<Node>::realloc(size_t capacity) {
+  _capacity = capacity;
   Node ** tmp = new Node *[_capacity];
   memcpy(tmp, _data, _size*sizeof(Node *));
   delete[] _data;
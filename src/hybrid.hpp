@@ -8,9 +8,34 @@ enum class hybrid_status {
   DEGENERATE
 };
 
+/**
+ * Find a zero of f in [a, b] using Wilkinson's hybrid method (a
+ * safeguarded secant method). If f(a) and f(b) have the same sign,
+ * the status is DEGENERATE.
+ *
+ * If niters > 0, at most niters evaluations of f are made after f(a)
+ * and f(b); if the cap is hit, the midpoint of the current bracket is
+ * returned (the status is still OK). If iters isn't null, the number
+ * of evaluations made after f(a) and f(b) is stored there.
+ */
 template <class F, class T>
 std::pair<T, hybrid_status>
-hybrid(F const & f, T a, T b, T tol = std::numeric_limits<T>::epsilon());
+hybrid(F const & f, T a, T b, T tol = std::numeric_limits<T>::epsilon(),
+       int niters = 0, int * iters = nullptr);
+
+/**
+ * Like hybrid, but for functions whose derivative is cheap to compute
+ * along with their value: fdf(x, df) returns f(x) and sets df to
+ * f'(x). This takes Newton steps, falling back to bisection when a
+ * Newton step would leave the current bracket or isn't making enough
+ * progress, so it converges quadratically near a simple zero and
+ * never does worse than bisection.
+ */
+template <class F, class T>
+std::pair<T, hybrid_status>
+hybrid_newton(F const & fdf, T a, T b,
+              T tol = std::numeric_limits<T>::epsilon(),
+              int niters = 0, int * iters = nullptr);
 
 #include "hybrid.impl.hpp"
 
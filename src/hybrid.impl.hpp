@@ -3,28 +3,25 @@
 
 #include <assert.h>
 
-// TODO: almost all of the uses of this in hybrid are to check if the
-// sign of two numbers is the same or different: we might be able to
-// speed this up by using this function from Stephen Canon on SO:
-//
-// template <typename T>
-// inline bool samesign(T a, T b) {
-//   return a*b >= 0;
-// }
-//
-// See here for a few comments:
-// https://stackoverflow.com/questions/2922619/how-to-efficiently-compare-the-sign-of-two-floating-point-values-while-handling
-//
-// This may be worth trying out since it appears that most of the time
-// spent *inside* hybrid (i.e., not in calls to f), is spent in `sgn'.
 template <typename T> int sgn(T val) {
   return (T(0) < val) - (val < T(0));
 }
 
+// Equivalent to sgn(a) == sgn(b), but without the conversions to int
+// or a short-circuiting && (so that the compiler can emit a couple of
+// compares and an and instead of a branch). Most of the time spent
+// *inside* hybrid (i.e., not in calls to f) used to be spent in sign
+// tests like this one.
+template <typename T> inline bool samesign(T a, T b) {
+  return ((T(0) < a) == (T(0) < b)) & ((a < T(0)) == (b < T(0)));
+}
+
 template <class F, class T>
 std::pair<T, hybrid_status>
-hybrid(F const & f, T a, T b, T tol)
+hybrid(F const & f, T a, T b, T tol, int niters, int * iters)
 {
+  if (iters) *iters = 0;
+
   T fa = f(a);
   if (fabs(fa)/fabs(a) <= tol) {
     return {a, hybrid_status::OK};
@@ -37,29 +34,35 @@ hybrid(F const & f, T a, T b, T tol)
 
   T c = a, fc = fa, fd, d, dm, df, ds, dd;
 
-  if (sgn(fb) == sgn(fc)) {
+  if (samesign(fb, fc)) {
     return {0, hybrid_status::DEGENERATE};
   }
 
-  while (true) {
-    if (fabs(fc) < fabs(fb)) {
-      std::swap(b, c);
-      std::swap(fb, fc);
-      a = c;
-      fa = fc;
-    }
+  // The updates of (a, b, c) below are written as selects rather than
+  // branches: which way they go is close to random, so branches on
+  // them are mispredicted a lot of the time.
+  for (int k = 0; niters <= 0 || k < niters; ) {
+    // Make b the better of the two endpoints of the bracket.
+    bool const flip = fabs(fc) < fabs(fb);
+    T const b_old = b, fb_old = fb;
+    b = flip ? c : b;
+    fb = flip ? fc : fb;
+    c = flip ? b_old : c;
+    fc = flip ? fb_old : fc;
+    a = flip ? c : a;
+    fa = flip ? fc : fa;
     if (fabs(b - c) <= tol) {
       break;
     }
     dm = (c - b)/2;
     df = fa - fb;
     ds = fabs(df) < tol ? dm : -fb*(a - b)/df;
-    dd = sgn(ds) != sgn(dm) || fabs(ds) > fabs(dm) ? dm : ds;
-    if (fabs(dd) < tol) {
-      dd = tol*sgn(dm)/2;
-    }
+    dd = (!samesign(ds, dm) | (fabs(ds) > fabs(dm))) ? dm : ds;
+    dd = fabs(dd) < tol ? tol*sgn(dm)/2 : dd;
     d = b + dd;
     fd = f(d);
+    ++k;
+    if (iters) *iters = k;
     if (fabs(fd) < tol) {
       b = c = d;
       fb = fc = fd;
@@ -69,10 +72,9 @@ hybrid(F const & f, T a, T b, T tol)
     b = d;
     fa = fb;
     fb = fd;
-    if (sgn(fb) == sgn(fc)) {
-      c = a;
-      fc = fa;
-    }
+    bool const same = samesign(fb, fc);
+    c = same ? a : c;
+    fc = same ? fa : fc;
   }
 
   // NOTE: in G.W. Stewart's Afternotes chapter on this algorithm, he
@@ -82,4 +84,66 @@ hybrid(F const & f, T a, T b, T tol)
   return {(b + c)/2, hybrid_status::OK};
 }
 
+template <class F, class T>
+std::pair<T, hybrid_status>
+hybrid_newton(F const & fdf, T a, T b, T tol, int niters, int * iters)
+{
+  if (iters) *iters = 0;
+
+  T df;
+
+  T fa = fdf(a, df);
+  if (fabs(fa)/fabs(a) <= tol) {
+    return {a, hybrid_status::OK};
+  }
+
+  T fb = fdf(b, df);
+  if (fabs(fb)/fabs(b) <= tol) {
+    return {b, hybrid_status::OK};
+  }
+
+  if (samesign(fa, fb)) {
+    return {0, hybrid_status::DEGENERATE};
+  }
+
+  // Keep a bracket [lo, hi] (or [hi, lo]) such that f(lo) < 0 < f(hi),
+  // and start from the secant point, which lies inside of it. Like
+  // hybrid, this tolerates f being NaN at one of the endpoints (e.g.,
+  // for a factored update whose endpoint is the factoring center):
+  // that endpoint is treated as having the opposite sign of the other
+  // one, and we start from the midpoint instead.
+  bool const a_is_lo = (fa < 0) | (fb > 0);
+  T lo = a_is_lo ? a : b, hi = a_is_lo ? b : a;
+  T x = b - fb*(b - a)/(fb - fa), fx, dx = fabs(b - a), dx_old, x_newton;
+  x = (x - a)*(x - b) < 0 ? x : (a + b)/2;
+
+  for (int k = 0; niters <= 0 || k < niters; ) {
+    fx = fdf(x, df);
+    ++k;
+    if (iters) *iters = k;
+    if (fabs(fx) < tol) {
+      break;
+    }
+    lo = fx < 0 ? x : lo;
+    hi = fx < 0 ? hi : x; // (including when fx is NaN)
+
+    // Take the Newton step if it stays strictly inside the bracket
+    // and is at most half as long as the step before last (as in
+    // rtsafe from Numerical Recipes). Otherwise, bisect. If df is
+    // zero or NaN, x_newton isn't finite and the tests below fail.
+    x_newton = x - fx/df;
+    dx_old = dx;
+    bool const newton =
+      ((x_newton - lo)*(x_newton - hi) < 0) & (fabs(2*fx) <= fabs(dx_old*df));
+    T const x_new = newton ? x_newton : (lo + hi)/2;
+    dx = fabs(x_new - x);
+    x = x_new;
+    if (dx <= tol) {
+      break;
+    }
+  }
+
+  return {x, hybrid_status::OK};
+}
+
 #endif // __HYBRID_IMPL_HPP__
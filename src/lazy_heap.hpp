@@ -0,0 +1,257 @@
+#ifndef __LAZY_HEAP_HPP__
+#define __LAZY_HEAP_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "common.hpp"
+
+/**
+ * A d-ary min-heap of {key, index} entries without decrease-key. When
+ * a trial node's value is lowered, `swim' just pushes another entry
+ * for it, and entries which have gone stale (the node has since been
+ * accepted, or its value no longer matches the entry's key) are
+ * thrown away when they reach the top of the heap. No per-node heap
+ * position is stored anywhere, and no entries are moved except by
+ * pushes and pops.
+ *
+ * As with `dary_heap', the index of each entry is the node's linear
+ * index in the marcher's node array, which is passed to the heap
+ * using `set_nodes' (see `set_node_array' below). The size of the heap
+ * is the number of trial nodes it contains, not the number of
+ * entries.
+ *
+ * The marchers stage far nodes by inserting them with an infinite
+ * value and then lowering it right away. Pushing these entries would
+ * leave a dead entry at the bottom of the heap for almost every node,
+ * so instead they're appended to a separate list which is only
+ * looked at once the heap itself is empty.
+ */
+template <class Node, int d>
+struct lazy_heap
+{
+  static_assert(d >= 2, "d must be at least 2");
+
+  lazy_heap(size_t capacity);
+  ~lazy_heap();
+
+  Node * front();
+  bool empty() const;
+  size_t size() const;
+  void pop_front();
+  void insert(Node * n);
+  void swim(Node * n);
+  void reserve(size_t capacity);
+
+  void set_nodes(Node * nodes, size_t num_nodes);
+
+EIKONAL_PRIVATE:
+  static constexpr size_t arity = d;
+
+  struct entry {
+    double key;
+    uint32_t index;
+  };
+
+  void push(Node * n);
+  void pop();
+  void skip_stale_entries();
+  void realloc(size_t capacity);
+  void compact_inf();
+
+  entry * _data {nullptr};
+  uint32_t * _inf {nullptr};
+  size_t _num_inf {0};
+  size_t _inf_capacity {0};
+  Node * _nodes {nullptr};
+  size_t _num_nodes {0};
+  size_t _num_entries {0};
+  size_t _size {0};
+  size_t _capacity {0};
+};
+
+template <class Node> using lazy_heap4 = lazy_heap<Node, 4>;
+
+template <class Node, int d>
+lazy_heap<Node, d>::lazy_heap(size_t capacity) {
+  realloc(capacity < arity ? arity : capacity);
+}
+
+template <class Node, int d>
+lazy_heap<Node, d>::~lazy_heap() {
+  delete[] _data;
+  delete[] _inf;
+}
+
+template <class Node, int d>
+Node * lazy_heap<Node, d>::front() {
+  assert(_size > 0);
+  skip_stale_entries();
+  return _nodes + (_num_entries > 0 ? _data[0].index : _inf[_num_inf - 1]);
+}
+
+template <class Node, int d>
+bool lazy_heap<Node, d>::empty() const {
+  return _size == 0;
+}
+
+template <class Node, int d>
+size_t lazy_heap<Node, d>::size() const {
+  return _size;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::pop_front() {
+  assert(_size > 0);
+  skip_stale_entries();
+  if (_num_entries > 0) {
+    pop();
+  } else {
+    --_num_inf;
+  }
+  --_size;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::insert(Node * n) {
+  push(n);
+  ++_size;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::swim(Node * n) {
+  push(n);
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::reserve(size_t capacity) {
+  if (capacity > _capacity) {
+    realloc(capacity);
+  }
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::set_nodes(Node * nodes, size_t num_nodes) {
+  assert(_size == 0);
+  assert(num_nodes <= UINT32_MAX);
+  _nodes = nodes;
+  _num_nodes = num_nodes;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::push(Node * n) {
+  assert(_nodes != nullptr);
+  assert(static_cast<size_t>(n - _nodes) < _num_nodes);
+  if (isinf(n->get_value())) {
+    if (_num_inf == _inf_capacity) {
+      compact_inf();
+    }
+    _inf[_num_inf++] = static_cast<uint32_t>(n - _nodes);
+    return;
+  }
+  if (_num_entries == _capacity) {
+    realloc(2*_capacity);
+  }
+  entry e {n->get_value(), static_cast<uint32_t>(n - _nodes)};
+  size_t pos = _num_entries++;
+  while (pos > 0) {
+    size_t parent = (pos - 1)/arity;
+    if (_data[parent].key <= e.key) {
+      break;
+    }
+    _data[pos] = _data[parent];
+    pos = parent;
+  }
+  _data[pos] = e;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::pop() {
+  assert(_num_entries > 0);
+  entry e = _data[--_num_entries];
+  size_t pos = 0, ch;
+  while ((ch = arity*pos + 1) < _num_entries) {
+    size_t end = ch + arity < _num_entries ? ch + arity : _num_entries;
+    size_t min = ch;
+    for (size_t c = ch + 1; c < end; ++c) {
+      if (_data[c].key < _data[min].key) {
+        min = c;
+      }
+    }
+    if (e.key <= _data[min].key) {
+      break;
+    }
+    _data[pos] = _data[min];
+    pos = min;
+  }
+  _data[pos] = e;
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::skip_stale_entries() {
+  // An entry is stale if its node has already been accepted, or if
+  // the node's value was lowered after the entry was pushed (in which
+  // case a newer entry for the node exists).
+  while (_num_entries > 0) {
+    auto const & e = _data[0];
+    Node const * n = _nodes + e.index;
+    if (n->is_trial() && n->get_value() == e.key) {
+      return;
+    }
+    pop();
+  }
+  while (_num_inf > 0) {
+    Node const * n = _nodes + _inf[_num_inf - 1];
+    if (n->is_trial() && isinf(n->get_value())) {
+      return;
+    }
+    --_num_inf;
+  }
+  assert(false);
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::compact_inf() {
+  // Almost every node in this list has had its value lowered since
+  // it was appended, so try throwing these away before growing it.
+  size_t num_inf = 0;
+  for (size_t i = 0; i < _num_inf; ++i) {
+    Node const * n = _nodes + _inf[i];
+    if (n->is_trial() && isinf(n->get_value())) {
+      _inf[num_inf++] = _inf[i];
+    }
+  }
+  _num_inf = num_inf;
+  if (2*_num_inf >= _inf_capacity) {
+    _inf_capacity = _inf_capacity == 0 ? 64 : 2*_inf_capacity;
+    uint32_t * tmp = new uint32_t[_inf_capacity];
+    if (_inf != nullptr) {
+      memcpy(tmp, _inf, _num_inf*sizeof(uint32_t));
+      delete[] _inf;
+    }
+    _inf = tmp;
+  }
+}
+
+template <class Node, int d>
+void lazy_heap<Node, d>::realloc(size_t capacity) {
+  entry * tmp = new entry[capacity];
+  if (_data != nullptr) {
+    memcpy(tmp, _data, _num_entries*sizeof(entry));
+    delete[] _data;
+  }
+  _data = tmp;
+  _capacity = capacity;
+}
+
+template <class Node, int d>
+inline void set_node_array(lazy_heap<Node, d> & q, Node * nodes, size_t n) {
+  q.set_nodes(nodes, n);
+}
+
+#endif // __LAZY_HEAP_HPP__
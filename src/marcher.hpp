@@ -5,13 +5,18 @@
 
 // TODO: try to remove this
 #include <functional>
+#include <memory>
 
 #include "abstract_marcher.hpp"
+#include "bucket_queue.hpp"
+#include "dary_heap.hpp"
+#include "lazy_heap.hpp"
 #include "speed_funcs.hpp"
 #include "typedefs.h"
 
-template <class base, class node, int num_neighbors>
-struct marcher: public abstract_marcher {
+template <class base, class node, int num_neighbors,
+          template <class> class queue = heap>
+struct marcher: public abstract_marcher<node, queue> {
   // These are for use with our pybind11 bindings. They aren't used
   // internally.
   using float_type = double;
@@ -22,6 +27,8 @@ struct marcher: public abstract_marcher {
 
   marcher(int height, int width, double h, no_speed_func_t const &);
   marcher(int height, int width, double h, double const * s_cache);
+  marcher(int height, int width, double h,
+          std::shared_ptr<double const> s_cache);
   marcher(int height, int width, double h = 1,
           std::function<double(double, double)> speed =
             static_cast<speed_func>(default_speed_func),
@@ -33,8 +40,13 @@ struct marcher: public abstract_marcher {
   void add_boundary_nodes(node const * nodes, int num_nodes);
   void add_boundary_nodes(node const * const * nodes, int num_nodes);
   void set_node_fac_center(int i, int j, typename node::fac_center const * fc);
+  void reset();
 
-  node * get_node_pointer() const { return _nodes; }
+  // See the comment for visit_neighbors_impl in abstract_marcher.hpp.
+  void run();
+  void step();
+
+  node * get_node_pointer() const { return _nodes + node_index(0, 0); }
   double get_speed(int i, int j) const;
   double get_value(int i, int j) const;
   int get_height() const { return _height; }
@@ -45,6 +57,13 @@ struct marcher: public abstract_marcher {
   node const & operator()(int i, int j) const;
 
 EIKONAL_PROTECTED:
+  // The node array is padded with a layer of barrier nodes (see
+  // init), so the neighbors of a node on the boundary of the grid can
+  // be looked at without checking if they're in bounds.
+  inline int node_index(int i, int j) const {
+    return (_width + 2)*(i + 1) + j + 1;
+  }
+
   bool in_bounds(int i, int j) const;
   bool in_bounds(double i, double j) const;
   bool is_valid(int i, int j) const;
@@ -56,14 +75,19 @@ EIKONAL_PROTECTED:
 
 EIKONAL_PRIVATE:
   void init();
+  void init_queue();
 
-  virtual void visit_neighbors_impl(abstract_node * n);
+  virtual void visit_neighbors_impl(node * n);
 
   node * _nodes;
   double const * _s_cache {nullptr};
+  std::shared_ptr<double const> _s_cache_owner; // (if s_cache is borrowed)
   double _h {1};
   int _height;
   int _width;
+  int _nb_offsets[8];
+  int _child_nb_index[num_neighbors][num_neighbors];
+  bool _queue_initialized {false};
 };
 
 #include "marcher.impl.hpp"
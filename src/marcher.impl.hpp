@@ -11,15 +11,23 @@
 #define __di(k) di<2>[k]
 #define __dj(k) dj<2>[k]
 
+/**
+ * The front spreading from a point source never holds more trial
+ * nodes than there are nodes on the boundary of the grid (for a
+ * source in the middle of the grid, olim4 peaks at about 0.7 times
+ * the perimeter and olim8 at about 1.0 times), so we size the heap
+ * using the perimeter to avoid growing it while marching.
+ */
 static inline size_t get_initial_heap_size(int width, int height) {
-  return static_cast<size_t>(fmax(8.0, log(width*height)));
+  return static_cast<size_t>(std::max(8, 2*(width + height)));
 }
 
-template <class base, class node, int num_neighbors>
-marcher<base, node, num_neighbors>::marcher(
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher<base, node, num_neighbors, queue>::marcher(
   int height, int width, double h, no_speed_func_t const &):
-  abstract_marcher {get_initial_heap_size(width, height)},
-  _nodes {new node[width*height]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height)},
+  _nodes {new node[(width + 2)*(height + 2)]},
   _s_cache {new double[width*height]},
   _h {h},
   _height {height},
@@ -28,11 +36,12 @@ marcher<base, node, num_neighbors>::marcher(
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher<base, node, num_neighbors>::marcher(
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher<base, node, num_neighbors, queue>::marcher(
   int height, int width, double h, double const * s_cache):
-  abstract_marcher {get_initial_heap_size(width, height)},
-  _nodes {new node[width*height]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height)},
+  _nodes {new node[(width + 2)*(height + 2)]},
   _s_cache {new double[width*height]},
   _h {h},
   _height {height},
@@ -42,12 +51,35 @@ marcher<base, node, num_neighbors>::marcher(
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher<base, node, num_neighbors>::marcher(
+/**
+ * Use `s_cache' as the speed function cache without copying it (it's
+ * laid out row-major, like get_speed expects), holding onto the
+ * shared_ptr so that it outlives the marcher. See the corresponding
+ * constructor in marcher_3d.impl.hpp.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher<base, node, num_neighbors, queue>::marcher(
+  int height, int width, double h, std::shared_ptr<double const> s_cache):
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height)},
+  _nodes {new node[(width + 2)*(height + 2)]},
+  _s_cache {s_cache.get()},
+  _s_cache_owner {std::move(s_cache)},
+  _h {h},
+  _height {height},
+  _width {width}
+{
+  assert(_s_cache != nullptr);
+  init();
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher<base, node, num_neighbors, queue>::marcher(
   int height, int width, double h,
   std::function<double(double, double)> s, double x0, double y0):
-  abstract_marcher {get_initial_heap_size(width, height)},
-  _nodes {new node[width*height]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height)},
+  _nodes {new node[(width + 2)*(height + 2)]},
   _s_cache {new double[width*height]},
   _h {h},
   _height {height},
@@ -62,14 +94,17 @@ marcher<base, node, num_neighbors>::marcher(
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher<base, node, num_neighbors>::~marcher()
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher<base, node, num_neighbors, queue>::~marcher()
 {
   assert(_nodes != nullptr);
   delete[] _nodes;
 
   assert(_s_cache != nullptr);
-  delete[] _s_cache;
+  if (_s_cache_owner == nullptr) {
+    delete[] _s_cache;
+  }
 }
 
 /**
@@ -81,23 +116,26 @@ marcher<base, node, num_neighbors>::~marcher()
  * to the node just added. This should be fixed, since there is a
  * correct way to enable this behavior.
  */
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::add_boundary_node(int i, int j, double value)
+marcher<base, node, num_neighbors, queue>::add_boundary_node(int i, int j, double value)
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j));
   assert(operator()(i, j).is_far());
 #endif
-  visit_neighbors(&(operator()(i, j) = {i, j, value}));
+  init_queue();
+  marcher::visit_neighbors_impl(&(operator()(i, j) = {i, j, value}));
 }
 
 #define LINE(p0, u0, s, s0, h)                          \
   updates::line<base::F_>()(norm2<2>(p0), u0, s, s0, h)
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::add_boundary_node(
+marcher<base, node, num_neighbors, queue>::add_boundary_node(
   double x, double y, double s, double value)
 {
 #if PRINT_UPDATES
@@ -107,6 +145,8 @@ marcher<base, node, num_neighbors>::add_boundary_node(
   double h = get_h(), i = y/h, j = x/h, u0 = value, s0 = s;
   assert(in_bounds(i, j));
 
+  init_queue();
+
   // TODO: this isn't as general as it could be. We also want to
   // handle cases where i or j are grid-aligned, in which case we need
   // to process 6 nodes. If i and j are both grid aligned, then we
@@ -127,15 +167,16 @@ marcher<base, node, num_neighbors>::add_boundary_node(
     assert(in_bounds(i_, j_));
     assert(operator()(i_, j_).is_far());
     double s_hat = get_speed(i_, j_), u_hat = LINE(P[a], u0, s_hat, s0, h);
-    insert_into_heap(&(operator()(i_, j_) = {i_, j_, u_hat, state::trial}));
+    this->insert_into_heap(&(operator()(i_, j_) = {i_, j_, u_hat, state::trial}));
   }
 }
 
 #undef LINE
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::add_boundary_nodes(
+marcher<base, node, num_neighbors, queue>::add_boundary_nodes(
   node const * nodes, int num)
 {
   node const * const * tmp = malloc(sizeof(node const * const *)*num);
@@ -146,24 +187,28 @@ marcher<base, node, num_neighbors>::add_boundary_nodes(
   free(tmp);
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::add_boundary_nodes(
+marcher<base, node, num_neighbors, queue>::add_boundary_nodes(
   node const * const * nodes, int num)
 {
+  init_queue();
+  this->reserve_heap(this->_heap.size() + num_neighbors*num);
   for (int k = 0; k < num; ++k) {
     auto n = nodes[k];
     int i = n->get_i(), j = n->get_j();
     assert(in_bounds(i, j));
     assert(operator()(i, j).is_far());
     double u = n->get_value();
-    insert_into_heap(&(operator()(i, j) = {i, j, u, state::trial}));
+    this->insert_into_heap(&(operator()(i, j) = {i, j, u, state::trial}));
   }
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::set_node_fac_center(
+marcher<base, node, num_neighbors, queue>::set_node_fac_center(
   int i, int j, typename node::fac_center const * fc)
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
@@ -173,9 +218,10 @@ marcher<base, node, num_neighbors>::set_node_fac_center(
   operator()(i, j).set_fac_center(fc);
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 double
-marcher<base, node, num_neighbors>::get_value(int i, int j) const
+marcher<base, node, num_neighbors, queue>::get_value(int i, int j) const
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j));
@@ -183,43 +229,48 @@ marcher<base, node, num_neighbors>::get_value(int i, int j) const
   return operator()(i, j).get_value();
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 node &
-marcher<base, node, num_neighbors>::operator()(int i, int j)
+marcher<base, node, num_neighbors, queue>::operator()(int i, int j)
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j));
   assert(_nodes != nullptr);
 #endif
-  return _nodes[_width*i + j];
+  return _nodes[node_index(i, j)];
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 node const &
-marcher<base, node, num_neighbors>::operator()(int i, int j) const
+marcher<base, node, num_neighbors, queue>::operator()(int i, int j) const
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j));
   assert(_nodes != nullptr);
 #endif
-  return _nodes[_width*i + j];
+  return _nodes[node_index(i, j)];
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 bool
-marcher<base, node, num_neighbors>::in_bounds(int i, int j) const
+marcher<base, node, num_neighbors, queue>::in_bounds(int i, int j) const
 {
   return (unsigned) i < (unsigned) _height && (unsigned) j < (unsigned) _width;
 }
 
-template <class base, class node, int num_neighbors>
-bool marcher<base, node, num_neighbors>::in_bounds(double i, double j) const {
-  return 0 <= i <= _height - 1 && 0 <= j <= _width - 1;
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+bool marcher<base, node, num_neighbors, queue>::in_bounds(double i, double j) const {
+  return 0 <= i && i <= _height - 1 && 0 <= j && j <= _width - 1;
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 double
-marcher<base, node, num_neighbors>::get_speed(int i, int j) const
+marcher<base, node, num_neighbors, queue>::get_speed(int i, int j) const
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j));
@@ -228,17 +279,29 @@ marcher<base, node, num_neighbors>::get_speed(int i, int j) const
   return _s_cache[_width*i + j];
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 bool
-marcher<base, node, num_neighbors>::is_valid(int i, int j) const
+marcher<base, node, num_neighbors, queue>::is_valid(int i, int j) const
 {
   return in_bounds(i, j) && operator()(i, j).is_valid();
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::init()
+marcher<base, node, num_neighbors, queue>::init()
 {
+  /**
+   * Surround the grid with a layer of barrier nodes: these are never
+   * far or valid, so visit_neighbors_impl skips them without having
+   * to check bounds.
+   */
+  int size = (_height + 2)*(_width + 2);
+  for (int l = 0; l < size; ++l) {
+    _nodes[l].set_state(state::barrier);
+  }
+
   /**
    * Set the indices associated with each node in the grid.
    */
@@ -246,77 +309,146 @@ marcher<base, node, num_neighbors>::init()
     for (int j = 0; j < _width; ++j) {
       operator()(i, j).set_i(i);
       operator()(i, j).set_j(j);
+      operator()(i, j).set_far();
+    }
+  }
+
+  /**
+   * Precompute the offsets of the neighbors of a node in the (padded)
+   * node array, and, for each neighbor k, where to find the valid
+   * neighbors of k among the valid neighbors of the node being
+   * visited (-1 if they aren't in its neighborhood).
+   */
+  for (int k = 0; k < 8; ++k) {
+    _nb_offsets[k] = node_index(__di(k), __dj(k)) - node_index(0, 0);
+  }
+  for (int k = 0; k < num_neighbors; ++k) {
+    for (int l = 0; l < num_neighbors; ++l) {
+      int di_kl = __di(k) + __di(l), dj_kl = __dj(k) + __dj(l);
+      _child_nb_index[k][l] = std::abs(di_kl) > 1 || std::abs(dj_kl) > 1 ?
+        -1 : d2l(di_kl, dj_kl);
     }
   }
+
+  set_node_array(this->_heap, _nodes, size);
 }
 
-template <class base, class node, int num_neighbors>
+/**
+ * Reset each node to far (clearing its value and factoring center)
+ * so that the marcher can be run again with a different set of
+ * boundary nodes. The heap is kept, so a second run doesn't need to
+ * allocate it again. The speed function is left as is, but it may
+ * have been modified through `get_s_cache_data' before calling this.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void
+marcher<base, node, num_neighbors, queue>::reset()
+{
+  while (!this->_heap.empty()) {
+    this->get_next_node();
+  }
+  for (int i = 0; i < _height; ++i) {
+    for (int j = 0; j < _width; ++j) {
+      operator()(i, j) = {i, j, inf<double>, state::far};
+    }
+  }
+  _queue_initialized = false;
+}
+
+/**
+ * These are the same as abstract_marcher::run and step, except that
+ * we call visit_neighbors_impl (and, from there, the base class's
+ * update_impl) non-virtually.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void
+marcher<base, node, num_neighbors, queue>::run()
+{
+  while (!this->_heap.empty()) {
+    marcher::visit_neighbors_impl(this->get_next_node());
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void
+marcher<base, node, num_neighbors, queue>::step()
+{
+  marcher::visit_neighbors_impl(this->get_next_node());
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher<base, node, num_neighbors>::visit_neighbors_impl(abstract_node * n)
+marcher<base, node, num_neighbors, queue>::init_queue()
 {
-  int i = static_cast<node *>(n)->get_i();
-  int j = static_cast<node *>(n)->get_j();
+  if (_queue_initialized) {
+    return;
+  }
 
-  // These are temporary indices used below, analogous to i and j,
-  // respectively.
-  int a, b;
+  // Some queues (e.g. bucket_queue) order nodes on the scale of
+  // T/(s_min*h), so we need to find the smallest speed before we
+  // start inserting nodes.
+  double s_min = inf<double>;
+  for (int l = 0; l < _height*_width; ++l) {
+    s_min = fmin(s_min, _s_cache[l]);
+  }
+  set_key_scale(this->_heap, s_min*_h);
+  _queue_initialized = true;
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void
+marcher<base, node, num_neighbors, queue>::visit_neighbors_impl(node * n)
+{
+  n->set_valid();
 
   // Traverse the update neighborhood of n and set all far nodes to
-  // trial and insert them into the heap.
+  // trial and insert them into the heap. The neighbors are found
+  // using the offsets computed in init.
   for (int k = 0; k < num_neighbors; ++k) {
-    a = i + __di(k), b = j + __dj(k);
-    if (in_bounds(a, b) && operator()(a, b).is_far()) {
-      operator()(a, b).set_trial();
-      insert_into_heap(&operator()(a, b));
+    node * nb_node = n + _nb_offsets[k];
+    if (nb_node->is_far()) {
+      nb_node->set_trial();
+      this->insert_into_heap(nb_node);
     }
   }
 
   // Find the valid neighbors in the "full" neighborhood of n
   // (i.e. the unit max norm ball).
-  memset(valid, 0x0, 8*sizeof(abstract_node *));
   for (int k = 0; k < 8; ++k) {
-    a = i + __di(k), b = j + __dj(k);
-    if (in_bounds(a, b) && operator()(a, b).is_valid()) {
-      valid[k] = &this->operator()(a, b);
-    }
+    node * nb_node = n + _nb_offsets[k];
+    valid[k] = nb_node->is_valid() ? nb_node : nullptr;
   }
 
   // Some explanation of the indices used below:
-  // - l is a radial index circling (a, b)
-  // - parent is the radial index of (i, j) expressed in the same
-  //   index space as l
-  int di_k, dj_k;
+  // - k is the radial index of the node being updated
+  // - l is a radial index circling the node being updated
+  // - parent is the radial index of n expressed in the same index
+  //   space as l
   node ** nb = static_cast<base *>(this)->nb;
-  auto const set_nb = [&] (int parent) {
-    memset(nb, 0x0, num_neighbors*sizeof(abstract_node *));
-    nb[parent] = static_cast<node *>(n);
+  auto const set_nb = [&] (int k, int parent) {
     for (int l = 0; l < num_neighbors; ++l) {
-      if (l == parent) {
-        continue;
-      }
-      int di_kl, dj_kl;
-      if (std::abs(di_kl = di_k + __di(l)) > 1 ||
-          std::abs(dj_kl = dj_k + __dj(l)) > 1) {
-        continue;
-      }
-      if (in_bounds(i + di_kl, j + dj_kl)) {
-        int m = d2l(di_kl, dj_kl);
-        nb[l] = valid[m];
-      }
+      int m = _child_nb_index[k][l];
+      nb[l] = m < 0 ? nullptr : valid[m];
     }
+    nb[parent] = n;
   };
 
-  // Update the node at (i, j). Before calling, `nb' needs to be
+  // Update `update_node'. Before calling, `nb' needs to be
   // filled appropriately. Upon updating, this sets the value of n and
   // adjusts its position in the heap.
-  auto const update = [&] (int i, int j) {
+  auto const update = [&] (node * update_node) {
     auto T = inf<double>;
-    node * update_node = &operator()(i, j);
-    static_cast<base *>(this)->s_hat = this->get_speed(i, j);
-    update_impl(update_node, T);
+    static_cast<base *>(this)->s_hat =
+      this->get_speed(update_node->get_i(), update_node->get_j());
+    static_cast<base *>(this)->base::update_impl(update_node, T);
     if (T < update_node->get_value()) {
       update_node->set_value(T);
-      adjust_heap_entry(update_node);
+      this->adjust_heap_entry(update_node);
     }
   };
 
@@ -337,12 +469,11 @@ marcher<base, node, num_neighbors>::visit_neighbors_impl(abstract_node * n)
   // heap.
   for (int k = 0; k < num_neighbors; ++k) {
     if (!valid[k]) {
-      di_k = __di(k), dj_k = __dj(k);
-      a = i + di_k, b = j + dj_k;
-      if (!in_bounds(a, b)) continue;
+      node * update_node = n + _nb_offsets[k];
+      if (update_node->get_state() == state::barrier) continue;
       int parent = get_parent(k);
-      set_nb(parent);
-      update(a, b);
+      set_nb(k, parent);
+      update(update_node);
     }
   }
 }
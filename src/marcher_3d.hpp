@@ -3,20 +3,38 @@
 
 // TODO: try to remove this
 #include <functional>
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+
+#include <src/config.hpp>
 
 #include "abstract_marcher.hpp"
+#include "bucket_queue.hpp"
+#include "dary_heap.hpp"
+#include "lazy_heap.hpp"
 #include "speed_funcs.hpp"
 #include "typedefs.h"
 
-template <class base, class node, int num_neighbors>
-struct marcher_3d: public abstract_marcher {
-  // These are for use with our pybind11 bindings. They aren't used
-  // internally.
-  using float_type = double;
+template <class base, class node, int num_neighbors,
+          template <class> class queue = heap>
+struct marcher_3d: public abstract_marcher<node, queue> {
+  // These are for use with our pybind11 bindings. The float type is
+  // also what the node values and the speed function cache are stored
+  // as (the updates themselves are always done in double precision).
+  using float_type = typename node::float_type;
   using node_type = node;
 
   static constexpr int ndim = 3;
 
+  // See node_index.
+  static constexpr int tile_size = MARCHER_3D_TILE_SIZE;
+  static constexpr bool is_tiled = tile_size > 0;
+  static_assert(
+    !is_tiled || (tile_size >= 4 && !(tile_size & (tile_size - 1))),
+    "MARCHER_3D_TILE_SIZE should be a power of two (at least 4)");
+
   marcher_3d();
   marcher_3d(int height, int width, int depth, double h,
              no_speed_func_t const &);
@@ -26,6 +44,8 @@ struct marcher_3d: public abstract_marcher {
              double x0 = 0.0, double y0 = 0.0, double z0 = 0.0);
   marcher_3d(int height, int width, int depth, double h,
              double const * s_cache);
+  marcher_3d(int height, int width, int depth, double h,
+             std::shared_ptr<double const> s_cache);
   virtual ~marcher_3d();
 
   void add_boundary_node(int i, int j, int k, double value = 0.0);
@@ -33,10 +53,31 @@ struct marcher_3d: public abstract_marcher {
     double x, double y, double z, double s, double value = 0.0);
   void add_boundary_nodes(node const * nodes, int num_nodes);
   void add_boundary_nodes(node const * const * nodes, int num_nodes);
+  void add_trial_node(int i, int j, int k, double value);
+  void add_barrier_node(int i, int j, int k);
+  void allow_reopening(bool reopening = true);
   void set_node_fac_center(
     int i, int j, int k, typename node::fac_center const * fac);
+  void reset();
+
+  // See the comment for visit_neighbors_impl in abstract_marcher.hpp.
+  void run();
+  void step();
 
-  node * get_node_pointer() const { return _nodes; }
+  // March until the value of every trial node is greater than
+  // `bound', and return the smallest of them (or inf, if there aren't
+  // any trial nodes left). See parallel_marcher_3d.
+  double run_until(double bound);
+
+  // Solve using Gauss-Seidel fast sweeping instead of marching (see
+  // run_sweeps in marcher_3d.impl.hpp).
+  int run_sweeps(int max_sweeps = 0);
+  int sweep(int ordering);
+  void set_barrier_value(int i, int j, int k, double value);
+
+  node * get_node_pointer() const { return _nodes + node_index(0, 0, 0); }
+  int get_node_stride(int axis) const;
+  void copy_values(double * out) const;
   double get_speed(int i, int j, int k) const;
   double get_value(int i, int j, int k) const;
   int get_height() const { return _height; }
@@ -48,28 +89,120 @@ struct marcher_3d: public abstract_marcher {
   node const & operator()(int i, int j, int k) const;
 
 EIKONAL_PROTECTED:
+  // If the layout is tiled, the speed function cache is laid out just
+  // like the node array (padding included), so the indices agree.
   inline int linear_index(int i, int j, int k) const {
-    return _height*(_width*k + j) + i; // column-major
+    if constexpr (is_tiled) {
+      return node_index(i, j, k);
+    } else {
+      return _height*(_width*k + j) + i; // column-major
+    }
+  }
+
+  // The node array is padded with a layer of barrier nodes on each
+  // side (see init), so that the neighbors of a node on the boundary
+  // of the grid can be looked at without checking if they're in
+  // bounds. Use this to index it (and anything else which is indexed
+  // like it), and linear_index for the speed function cache.
+  //
+  // If the layout is tiled, the padded grid is split into cubes of
+  // tile_size^3 nodes, each stored contiguously (column-major inside
+  // of the tile, and the tiles themselves in column-major order), so
+  // the neighborhood of a node is spread over one to eight tiles
+  // instead of nine columns which are a whole slice of the grid apart.
+  // The index is a sum of one term for each coordinate.
+  inline int node_index(int i, int j, int k) const {
+    if constexpr (is_tiled) {
+      int const tiles_i = num_tiles(_height), tiles_j = num_tiles(_width);
+      return tile_term(i + 1, 1, 0) + tile_term(j + 1, tiles_i, tile_shift) +
+        tile_term(k + 1, tiles_i*tiles_j, 2*tile_shift);
+    } else {
+      return (_height + 2)*((_width + 2)*(k + 1) + j + 1) + i + 1;
+    }
+  }
+
+  // The sizes of the node array and of the speed function cache.
+  static int node_array_size(int height, int width, int depth);
+  static int linear_size(int height, int width, int depth);
+  int node_array_size() const {
+    return node_array_size(_height, _width, _depth);
   }
+  int linear_size() const { return linear_size(_height, _width, _depth); }
 
   bool in_bounds(int i, int j, int k) const;
   bool is_valid(int i, int j, int k) const;
   double get_h() const { return _h; }
 
-  virtual void update_impl(node * n, node ** nb, int parent, double & T) = 0;
+  // These hide where the node states, factoring centers, and indices
+  // are kept, which depends on the node type (see soa_node_3d.hpp).
+  state get_state(int l) const;
+  void set_state(int l, state s);
+  typename node::fac_center const * get_fac_center(int l) const;
+  void get_index(node const * n, int & i, int & j, int & k) const;
+
+  // Bit l of nb_mask is set if nb[l] is a valid node.
+  virtual void update_impl(
+    int i, int j, int k, node ** nb, uint32_t nb_mask, int parent,
+    double & T) = 0;
   
 EIKONAL_PRIVATE:
+  static constexpr int tile_shift = is_tiled ? __builtin_ctz(tile_size) : 0;
+  static constexpr int tile_mask = tile_size - 1;
+
+  static constexpr int num_tiles(int n) {
+    return (n + 2 + tile_mask) >> tile_shift;
+  }
+
+  // The term of the tiled node_index for the padded coordinate p,
+  // where `tiles' is the number of tiles making up a step along p.
+  static constexpr int tile_term(int p, int tiles, int shift) {
+    return ((p >> tile_shift)*tiles << 3*tile_shift) +
+      ((p & tile_mask) << shift);
+  }
+
+  // The offsets (in the node array) of the nodes in the 3x3x3 cube
+  // around a node, ordered by cube index (see __cube_index), and of
+  // its neighbors. The 28th cube offset is zero (see init).
+  struct neighborhood {
+    int cube[28];
+    int nb[26];
+  };
+
+  inline neighborhood const & get_neighborhood(
+    int i, int j, int k, neighborhood & tmp) const;
+
   void init();
+  void init_queue();
+  node * init_node(int i, int j, int k, double value, state s);
+  uint32_t get_valid_mask(int l, neighborhood const & nbhd) const;
+  void copy_s_cache(double const * s_cache);
+
+  virtual void visit_neighbors_impl(node * n);
 
-  virtual void visit_neighbors_impl(abstract_node * n);
+  void init_sweeping();
+  bool relax(int i, int j, int k, int l0);
+  void mark_neighbors_dirty(int i, int j, int k, int l0);
 
   // We initialize all of these variables to an invalid state so that
   // we can assert that we're using them correctly later if we've
   // compiled in debug mode.
   node * _nodes {nullptr};
-  double const * _s_cache {nullptr};
+  state * _states {nullptr};
+  typename node::fac_center const ** _fac_centers {nullptr};
+  std::vector<typename node::fac_center const *> _fac_table {nullptr};
+  float_type const * _s_cache {nullptr};
+  std::shared_ptr<double const> _s_cache_owner; // (if s_cache is borrowed)
   double _h {-1};
   int _height {-1}, _width {-1}, _depth {-1};
+  uint8_t * _valid_bits {nullptr};
+  uint8_t * _boundary_bits {nullptr}; // (only used if reopening)
+  uint8_t * _late_bits {nullptr}; // (ditto)
+  uint8_t * _dirty_bits {nullptr}; // (only used when sweeping)
+  neighborhood _nbhd; // (if tiled, only for nodes inside of a tile)
+  int _nb_cube_index[26];
+  int _child_nb_cube_index[num_neighbors][num_neighbors];
+  bool _queue_initialized {false};
+  bool _reopening {false};
 };
 
 #include "marcher_3d.impl.hpp"
@@ -6,6 +6,8 @@
 #include <assert.h>
 #include <math.h>
 
+#include <type_traits>
+
 #include "offsets.hpp"
 #include "updates.line.hpp"
 
@@ -13,23 +15,39 @@
 #define __dj(l) dj<3>[l]
 #define __dk(l) dk<3>[l]
 
+#define __maxabs3(x, y, z) \
+  std::max(std::abs(x), std::max(std::abs(y), std::abs(z)))
+
+// The position of the offset (di, dj, dk) in the 3x3x3 cube around a
+// node, ordered like the node array (i.e., with di varying fastest).
+#define __cube_index(di, dj, dk) (9*((dk) + 1) + 3*((dj) + 1) + (di) + 1)
+
 #define __x(l) (h*l - x0)
 #define __y(l) (h*l - y0)
 #define __z(l) (h*l - z0)
 
+/**
+ * See the comment in marcher.impl.hpp. In 3D, we size the heap using
+ * the surface area of the grid: for a source in the middle of the
+ * grid, olim6 peaks at about 0.4 times the surface area and olim26 at
+ * about 0.8 times.
+ */
 static inline size_t get_initial_heap_size(int width, int height, int depth) {
-  return static_cast<size_t>(fmax(8.0, log(width*height*depth)));
+  return static_cast<size_t>(
+    std::max(8, 2*(width*height + height*depth + depth*width)));
 }
 
-template <class base, class node, int num_neighbors>
-marcher_3d<base, node, num_neighbors>::marcher_3d() {}
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::marcher_3d() {}
 
-template <class base, class node, int num_neighbors>
-marcher_3d<base, node, num_neighbors>::marcher_3d(int height, int width, int depth, double h,
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::marcher_3d(int height, int width, int depth, double h,
                                    no_speed_func_t const &):
-  abstract_marcher {get_initial_heap_size(width, height, depth)},
-  _nodes {new node[width*height*depth]},
-  _s_cache {new double[width*height*depth]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height, depth)},
+  _nodes {new node[node_array_size(height, width, depth)]},
+  _s_cache {new float_type[linear_size(height, width, depth)]},
   _h {h},
   _height {height},
   _width {width},
@@ -38,21 +56,23 @@ marcher_3d<base, node, num_neighbors>::marcher_3d(int height, int width, int dep
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher_3d<base, node, num_neighbors>::marcher_3d(
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::marcher_3d(
   int height, int width, int depth, double h,
   std::function<double(double, double, double)> s,
   double x0, double y0, double z0):
-  abstract_marcher {get_initial_heap_size(width, height, depth)},
-  _nodes {new node[width*height*depth]},
-  _s_cache {new double[width*height*depth]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height, depth)},
+  _nodes {new node[node_array_size(height, width, depth)]},
+  _s_cache {new float_type[linear_size(height, width, depth)]},
   _h {h},
   _height {height},
   _width {width},
   _depth {depth}
 {
   // Grab a writable pointer to cache the speed function values.
-  double x, z, * ptr = const_cast<double *>(_s_cache);
+  double x, z;
+  float_type * ptr = const_cast<float_type *>(_s_cache);
   for (int k = 0; k < depth; ++k) {
     z = __z(k);
     for (int j = 0; j < width; ++j) {
@@ -66,53 +86,189 @@ marcher_3d<base, node, num_neighbors>::marcher_3d(
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher_3d<base, node, num_neighbors>::marcher_3d(int height, int width, int depth, double h,
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::marcher_3d(int height, int width, int depth, double h,
                                    double const * s_cache):
-  abstract_marcher {get_initial_heap_size(width, height, depth)},
-  _nodes {new node[width*height*depth]},
-  _s_cache {new double[width*height*depth]},
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height, depth)},
+  _nodes {new node[node_array_size(height, width, depth)]},
+  _h {h},
+  _height {height},
+  _width {width},
+  _depth {depth}
+{
+  copy_s_cache(s_cache);
+  init();
+}
+
+/**
+ * Use `s_cache' as the speed function cache without copying it (it's
+ * laid out like linear_index), holding onto the shared_ptr so that it
+ * outlives the marcher. Several marchers can share the same cache
+ * this way, since they never write to it (get_s_cache_data shouldn't
+ * be used to write to a borrowed cache, though). If float_type isn't
+ * double or the layout is tiled, the cache has to be converted or
+ * reordered, so it's copied after all.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::marcher_3d(
+  int height, int width, int depth, double h,
+  std::shared_ptr<double const> s_cache):
+  abstract_marcher<node, queue> {get_initial_heap_size(width, height, depth)},
+  _nodes {new node[node_array_size(height, width, depth)]},
   _h {h},
   _height {height},
   _width {width},
   _depth {depth}
 {
-  memcpy((void *) _s_cache, (void *) s_cache,
-         sizeof(double)*height*width*depth);
+  assert(s_cache != nullptr);
+  if constexpr (std::is_same_v<float_type, double> && !is_tiled) {
+    _s_cache = s_cache.get();
+    _s_cache_owner = std::move(s_cache);
+  } else {
+    copy_s_cache(s_cache.get());
+  }
   init();
 }
 
-template <class base, class node, int num_neighbors>
-marcher_3d<base, node, num_neighbors>::~marcher_3d()
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+marcher_3d<base, node, num_neighbors, queue>::~marcher_3d()
 {
   assert(_nodes != nullptr);
   delete[] _nodes;
 
+  delete[] _states;
+  delete[] _fac_centers;
+  delete[] _valid_bits;
+  delete[] _boundary_bits;
+  delete[] _late_bits;
+  delete[] _dirty_bits;
+
   assert(_s_cache != nullptr);
-  delete[] _s_cache;
+  if (_s_cache_owner == nullptr) {
+    delete[] _s_cache;
+  }
 }
 
-template <class base, class node, int num_neighbors>
-void marcher_3d<base, node, num_neighbors>::add_boundary_node(
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::add_boundary_node(
   int i, int j, int k, double value)
 {
-  assert(operator()(i, j, k).is_far() || operator()(i, j, k).is_valid());
-  if (operator()(i, j, k).is_valid()) return;
   assert(in_bounds(i, j, k));
-  visit_neighbors(&(operator()(i, j, k) = {i, j, k, value}));
+  assert(get_state(node_index(i, j, k)) != state::trial);
+  if (get_state(node_index(i, j, k)) == state::valid) return;
+  init_queue();
+  if (_boundary_bits != nullptr) {
+    int l = node_index(i, j, k);
+    _boundary_bits[l >> 3] |= 1 << (l & 7);
+  }
+  if (_dirty_bits != nullptr) {
+    mark_neighbors_dirty(i, j, k, node_index(i, j, k));
+  }
+  marcher_3d::visit_neighbors_impl(init_node(i, j, k, value, state::valid));
+}
+
+/**
+ * Make the node at (i, j, k) a trial node whose value is at most
+ * `value', unless it's already valid (see allow_reopening, though).
+ * Unlike add_boundary_node, this doesn't visit the node's neighbors:
+ * they're updated once the node is popped from the heap, like any
+ * other trial node. This works for every node type (unlike
+ * add_boundary_nodes), and is what parallel_marcher_3d uses to pass
+ * values between its blocks. A barrier node (see add_barrier_node)
+ * can be made a trial node this way.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::add_trial_node(
+  int i, int j, int k, double value)
+{
+  assert(in_bounds(i, j, k));
+  int l = node_index(i, j, k);
+  state s = get_state(l);
+  init_queue();
+  if (s == state::valid) {
+    if (_reopening && value < _nodes[l].get_value() &&
+        !((_boundary_bits[l >> 3] >> (l & 7)) & 1)) {
+      _nodes[l].set_value(value);
+      set_state(l, state::trial);
+      _valid_bits[l >> 3] &= ~(1 << (l & 7));
+      this->insert_into_heap(&_nodes[l]);
+    }
+  } else if (s == state::trial) {
+    if (value < _nodes[l].get_value()) {
+      _nodes[l].set_value(value);
+      this->adjust_heap_entry(&_nodes[l]);
+    }
+  } else {
+    this->insert_into_heap(init_node(i, j, k, value, state::trial));
+  }
+  if (_reopening) {
+    _late_bits[l >> 3] |= 1 << (l & 7);
+  }
+}
+
+/**
+ * Make the node at (i, j, k) a barrier node, like the nodes padding
+ * the grid: it's never made a trial node or updated by its neighbors
+ * (until reset is called, or it's passed to add_trial_node). The
+ * node shouldn't have been reached yet.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::add_barrier_node(
+  int i, int j, int k)
+{
+  assert(in_bounds(i, j, k));
+  assert(get_state(node_index(i, j, k)) == state::far);
+  init_node(i, j, k, inf<double>, state::barrier);
+}
+
+/**
+ * If `reopening' is set, when a node passed to add_trial_node is
+ * accepted, its valid neighbors with larger values are updated too,
+ * and any whose value goes down is made a trial node again (and is
+ * treated the same way when it's accepted again). This lets the
+ * marcher fix nodes it accepted before it was told about a smaller
+ * value, as parallel_marcher_3d does. Only the nodes whose values
+ * actually change are reopened, and nodes which were reached the
+ * usual way don't reopen anything (MP0 and MP1 updates aren't
+ * always causal, so doing this for every node would change the
+ * result). Boundary nodes are never reopened, so this should be
+ * called before any are added.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::allow_reopening(
+  bool reopening)
+{
+  _reopening = reopening;
+  if (_reopening && _boundary_bits == nullptr) {
+    int size = node_array_size();
+    _boundary_bits = new uint8_t[size/8 + 2];
+    std::fill(_boundary_bits, _boundary_bits + size/8 + 2, 0);
+    _late_bits = new uint8_t[size/8 + 2];
+    std::fill(_late_bits, _late_bits + size/8 + 2, 0);
+  }
 }
 
 #define LINE(p0, u0, s, s0, h)                                  \
   updates::line<base::F_>()(norm2<3>(p0), u0, s, s0, h)
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher_3d<base, node, num_neighbors>::add_boundary_node(
+marcher_3d<base, node, num_neighbors, queue>::add_boundary_node(
   double x, double y, double z, double s, double value)
 {
   double h = get_h(), i = y/h, j = x/h, k = z/h, u0 = value, s0 = s;
   assert(in_bounds(i, j, k));
 
+  init_queue();
+
   // TODO: make this more general: see comment in marcher.impl.hpp for
   // related function
   int is[2] = {(int) floor(i), (int) floor(i) + 1};
@@ -134,19 +290,19 @@ marcher_3d<base, node, num_neighbors>::add_boundary_node(
     int b0 = a & 1, b1 = (a & 2) >> 1, b2 = (a & 4) >> 2;
     int i_ = is[b0], j_ = js[b1], k_ = ks[b2];
     assert(in_bounds(i_, j_, k_));
-    assert(operator()(i_, j_, k_).is_far());
+    assert(get_state(node_index(i_, j_, k_)) == state::far);
     double s_hat = get_speed(i_, j_, k_);
     double u_hat = LINE(ps[a], u0, s_hat, s0, h);
-    insert_into_heap(
-      &(operator()(i_, j_, k_) = {i_, j_, k_, u_hat, state::trial}));
+    this->insert_into_heap(init_node(i_, j_, k_, u_hat, state::trial));
   }
 }
 
 #undef LINE
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher_3d<base, node, num_neighbors>::add_boundary_nodes(
+marcher_3d<base, node, num_neighbors, queue>::add_boundary_nodes(
   node const * nodes, int num)
 {
   auto tmp = static_cast<node const **>(malloc(sizeof(void *)*num));
@@ -157,66 +313,97 @@ marcher_3d<base, node, num_neighbors>::add_boundary_nodes(
   free(tmp);
 }
 
-template <class base, class node, int num_neighbors>
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
 void
-marcher_3d<base, node, num_neighbors>::add_boundary_nodes(
+marcher_3d<base, node, num_neighbors, queue>::add_boundary_nodes(
   node const* const* nodes, int num)
 {
+  static_assert(!node::is_soa, "SoA nodes don't store their indices");
+  init_queue();
+  this->reserve_heap(this->_heap.size() + num_neighbors*num);
   for (int l = 0; l < num; ++l) {
     auto n = nodes[l];
     int i = n->get_i(), j = n->get_j(), k = n->get_k();
     assert(in_bounds(i, j, k));
-    assert(operator()(i, j, k).is_far());
+    assert(get_state(node_index(i, j, k)) == state::far);
     double u = n->get_value();
-    insert_into_heap(&(operator()(i, j, k) = {i, j, k, u, state::trial}));
+    this->insert_into_heap(init_node(i, j, k, u, state::trial));
   }
 }
 
-template <class base, class node, int num_neighbors>
-void marcher_3d<base, node, num_neighbors>::set_node_fac_center(
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::set_node_fac_center(
   int i, int j, int k, typename node::fac_center const * fc)
 {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j, k));
   assert(in_bounds(fc->i, fc->j, fc->k));
 #endif
-  operator()(i, j, k).set_fac_center(fc);
+  if constexpr (node::is_soa) {
+    if (_fac_centers == nullptr) {
+      int size = node_array_size();
+      _fac_centers = new typename node::fac_center const * [size];
+      std::fill(_fac_centers, _fac_centers + size, nullptr);
+    }
+    _fac_centers[node_index(i, j, k)] = fc;
+  } else if constexpr (node::has_fac_index) {
+    // There are usually only a handful of distinct factoring centers,
+    // and they're usually set for a block of nodes at a time, so just
+    // search the table starting from the end.
+    size_t index = _fac_table.size();
+    while (--index > 0 && _fac_table[index] != fc) {}
+    if (index == 0) {
+      index = _fac_table.size();
+      _fac_table.push_back(fc);
+    }
+    assert(index <= UINT32_MAX);
+    operator()(i, j, k).set_fac_index(static_cast<uint32_t>(index));
+  } else {
+    operator()(i, j, k).set_fac_center(fc);
+  }
 }
 
-template <class base, class node, int num_neighbors>
-double marcher_3d<base, node, num_neighbors>::get_value(int i, int j, int k) const {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+double marcher_3d<base, node, num_neighbors, queue>::get_value(int i, int j, int k) const {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j, k));
 #endif
   return operator()(i, j, k).get_value();
 }
 
-template <class base, class node, int num_neighbors>
-node & marcher_3d<base, node, num_neighbors>::operator()(int i, int j, int k) {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+node & marcher_3d<base, node, num_neighbors, queue>::operator()(int i, int j, int k) {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j, k));
   assert(_nodes != nullptr);
 #endif
-  return _nodes[linear_index(i, j, k)];
+  return _nodes[node_index(i, j, k)];
 }
 
-template <class base, class node, int num_neighbors>
-node const & marcher_3d<base, node, num_neighbors>::operator()(int i, int j, int k) const {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+node const & marcher_3d<base, node, num_neighbors, queue>::operator()(int i, int j, int k) const {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j, k));
   assert(_nodes != nullptr);
 #endif
-  return _nodes[linear_index(i, j, k)];
+  return _nodes[node_index(i, j, k)];
 }
 
-template <class base, class node, int num_neighbors>
-bool marcher_3d<base, node, num_neighbors>::in_bounds(int i, int j, int k) const {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+bool marcher_3d<base, node, num_neighbors, queue>::in_bounds(int i, int j, int k) const {
   return (unsigned) i < (unsigned) _height &&
     (unsigned) j < (unsigned) _width && (unsigned) k < (unsigned) _depth;
 }
 
-template <class base, class node, int num_neighbors>
-double marcher_3d<base, node, num_neighbors>::get_speed(int i, int j, int k) const {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+double marcher_3d<base, node, num_neighbors, queue>::get_speed(int i, int j, int k) const {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
   assert(in_bounds(i, j, k));
   assert(_s_cache != nullptr);
@@ -224,95 +411,682 @@ double marcher_3d<base, node, num_neighbors>::get_speed(int i, int j, int k) con
   return _s_cache[linear_index(i, j, k)];
 }
 
-template <class base, class node, int num_neighbors>
-bool marcher_3d<base, node, num_neighbors>::is_valid(int i, int j, int k) const {
-  return in_bounds(i, j, k) && operator()(i, j, k).is_valid();
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+bool marcher_3d<base, node, num_neighbors, queue>::is_valid(int i, int j, int k) const {
+  return in_bounds(i, j, k) && get_state(node_index(i, j, k)) == state::valid;
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+int marcher_3d<base, node, num_neighbors, queue>::get_node_stride(
+  int axis) const
+{
+  // A tiled node array can't be described using strides (use
+  // copy_values instead).
+  assert(!is_tiled);
+  assert(0 <= axis && axis < 3);
+  if (axis == 0) return 1;
+  else if (axis == 1) return _height + 2;
+  else return (_height + 2)*(_width + 2);
+}
+
+/**
+ * Copy the values of the nodes to `out', laid out column-major (like
+ * the speed function cache passed to the constructor), whatever the
+ * layout of the node array is.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::copy_values(
+  double * out) const
+{
+  for (int k = 0; k < _depth; ++k) {
+    for (int j = 0; j < _width; ++j) {
+      for (int i = 0; i < _height; ++i) {
+        *out++ = _nodes[node_index(i, j, k)].get_value();
+      }
+    }
+  }
 }
 
-template <class base, class node, int num_neighbors>
-void marcher_3d<base, node, num_neighbors>::init() {
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+inline state
+marcher_3d<base, node, num_neighbors, queue>::get_state(int l) const {
+  if constexpr (node::is_soa) {
+    return _states[l];
+  } else {
+    return _nodes[l].get_state();
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+inline void
+marcher_3d<base, node, num_neighbors, queue>::set_state(int l, state s) {
+  if constexpr (node::is_soa) {
+    _states[l] = s;
+  } else {
+    _nodes[l].set_state(s);
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+inline typename node::fac_center const *
+marcher_3d<base, node, num_neighbors, queue>::get_fac_center(int l) const {
+  if constexpr (node::is_soa) {
+    return _fac_centers == nullptr ? nullptr : _fac_centers[l];
+  } else if constexpr (node::has_fac_index) {
+    return _fac_table[_nodes[l].get_fac_index()];
+  } else {
+    return _nodes[l].get_fac_center();
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+inline void
+marcher_3d<base, node, num_neighbors, queue>::get_index(
+  node const * n, int & i, int & j, int & k) const
+{
+  if constexpr (node::is_soa && is_tiled) {
+    // Invert node_index: the low bits of l give the position in the
+    // tile, and the rest give the tile.
+    int l = static_cast<int>(n - _nodes);
+    int tile = l >> 3*tile_shift, tiles_i = num_tiles(_height);
+    i = ((tile % tiles_i) << tile_shift | (l & tile_mask)) - 1;
+    tile /= tiles_i;
+    j = ((tile % num_tiles(_width)) << tile_shift |
+         ((l >> tile_shift) & tile_mask)) - 1;
+    k = ((tile/num_tiles(_width)) << tile_shift |
+         ((l >> 2*tile_shift) & tile_mask)) - 1;
+  } else if constexpr (node::is_soa) {
+    // Invert node_index.
+    int l = static_cast<int>(n - _nodes);
+    i = l % (_height + 2) - 1;
+    l /= _height + 2;
+    j = l % (_width + 2) - 1;
+    k = l/(_width + 2) - 1;
+  } else {
+    i = n->get_i();
+    j = n->get_j();
+    k = n->get_k();
+  }
+}
+
+/**
+ * Overwrite the node at (i, j, k). As with assigning a new node_3d,
+ * this clears the node's factoring center.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+node * marcher_3d<base, node, num_neighbors, queue>::init_node(
+  int i, int j, int k, double value, state s)
+{
+  int l = node_index(i, j, k);
+  if constexpr (node::is_soa) {
+    _nodes[l] = {value};
+    _states[l] = s;
+    if (_fac_centers != nullptr) {
+      _fac_centers[l] = nullptr;
+    }
+  } else {
+    _nodes[l] = {i, j, k, value, s};
+  }
+  return &_nodes[l];
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+int marcher_3d<base, node, num_neighbors, queue>::node_array_size(
+  int height, int width, int depth)
+{
+  if constexpr (is_tiled) {
+    return (num_tiles(height)*num_tiles(width)*num_tiles(depth)) <<
+      3*tile_shift;
+  } else {
+    return (height + 2)*(width + 2)*(depth + 2);
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+int marcher_3d<base, node, num_neighbors, queue>::linear_size(
+  int height, int width, int depth)
+{
+  if constexpr (is_tiled) {
+    return node_array_size(height, width, depth);
+  } else {
+    return height*width*depth;
+  }
+}
+
+/**
+ * Allocate the speed function cache and copy `s_cache' (laid out
+ * column-major) into it, reordering it if the layout is tiled.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::copy_s_cache(
+  double const * s_cache)
+{
+  auto ptr = new float_type[linear_size()];
+  if constexpr (is_tiled) {
+    for (int k = 0; k < _depth; ++k) {
+      for (int j = 0; j < _width; ++j) {
+        for (int i = 0; i < _height; ++i) {
+          ptr[linear_index(i, j, k)] = *s_cache++;
+        }
+      }
+    }
+  } else {
+    std::copy(s_cache, s_cache + linear_size(), ptr);
+  }
+  _s_cache = ptr;
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::init() {
+  // Surround the grid with a layer of barrier nodes: since these are
+  // never far or valid, the neighbor loops in visit_neighbors_impl
+  // skip them without having to check bounds.
+  int size = node_array_size();
+  if constexpr (node::is_soa) {
+    _states = new state[size];
+  }
+  for (int l = 0; l < size; ++l) {
+    set_state(l, state::barrier);
+  }
+  if constexpr (node::has_fac_index) {
+    assert(_height <= INT16_MAX && _width <= INT16_MAX &&
+           _depth <= INT16_MAX);
+  }
   for (int i = 0; i < _height; ++i) {
     for (int j = 0; j < _width; ++j) {
       for (int k = 0; k < _depth; ++k) {
-        operator()(i, j, k).set_i(i);
-        operator()(i, j, k).set_j(j);
-        operator()(i, j, k).set_k(k);
+        set_state(node_index(i, j, k), state::far);
+        if constexpr (!node::is_soa) {
+          operator()(i, j, k).set_i(i);
+          operator()(i, j, k).set_j(j);
+          operator()(i, j, k).set_k(k);
+        }
       }
     }
   }
+
+  // One bit per node, set once the node is valid (see
+  // get_valid_mask). There's an extra byte at the end so that
+  // get_valid_mask can always read two bytes at a time.
+  _valid_bits = new uint8_t[size/8 + 2];
+  std::fill(_valid_bits, _valid_bits + size/8 + 2, 0);
+
+  // Precompute the offsets of the neighbors of a node in the (padded)
+  // node array. The valid masks returned by get_valid_mask are
+  // indexed by `cube index' (see __cube_index), so we also store the
+  // cube index of each neighbor l, and for each neighbor l the cube
+  // indices of the neighbors of l (or 27, which is never set, if they
+  // aren't in the neighborhood of the node being visited). This way,
+  // visit_neighbors_impl never has to convert indices.
+  //
+  // If the layout is tiled, these offsets only work for nodes which
+  // aren't on the face of a tile, like (0, 0, 0) (see
+  // get_neighborhood).
+  for (int l = 0; l < 26; ++l) {
+    _nb_cube_index[l] = __cube_index(__di(l), __dj(l), __dk(l));
+  }
+  for (int l = 0; l < num_neighbors; ++l) {
+    for (int m = 0; m < num_neighbors; ++m) {
+      int di_lm = __di(l) + __di(m);
+      int dj_lm = __dj(l) + __dj(m);
+      int dk_lm = __dk(l) + __dk(m);
+      _child_nb_cube_index[l][m] = __maxabs3(di_lm, dj_lm, dk_lm) > 1 ?
+        27 : __cube_index(di_lm, dj_lm, dk_lm);
+    }
+  }
+  for (int c = 0; c < 27; ++c) {
+    _nbhd.cube[c] = node_index(c % 3 - 1, (c/3) % 3 - 1, c/9 - 1) -
+      node_index(0, 0, 0);
+  }
+  _nbhd.cube[27] = 0;
+  for (int l = 0; l < 26; ++l) {
+    _nbhd.nb[l] = _nbhd.cube[_nb_cube_index[l]];
+  }
+
+  set_node_array(this->_heap, _nodes, size);
 }
 
-#define __maxabs3(x, y, z) \
-  std::max(std::abs(x), std::max(std::abs(y), std::abs(z)))
+/**
+ * See the comment for marcher::reset in marcher.impl.hpp.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::reset() {
+  while (!this->_heap.empty()) {
+    this->get_next_node();
+  }
+  for (int i = 0; i < _height; ++i) {
+    for (int j = 0; j < _width; ++j) {
+      for (int k = 0; k < _depth; ++k) {
+        init_node(i, j, k, inf<double>, state::far);
+      }
+    }
+  }
+  int size = node_array_size();
+  std::fill(_valid_bits, _valid_bits + size/8 + 2, 0);
+  if (_boundary_bits != nullptr) {
+    std::fill(_boundary_bits, _boundary_bits + size/8 + 2, 0);
+    std::fill(_late_bits, _late_bits + size/8 + 2, 0);
+  }
+  if (_dirty_bits != nullptr) {
+    std::fill(_dirty_bits, _dirty_bits + size/8 + 2, 0xff);
+  }
+  _queue_initialized = false;
+}
+
+/**
+ * Get the offsets of the nodes around (i, j, k). These are the
+ * precomputed ones in _nbhd, unless the layout is tiled and the node
+ * is on the face of a tile, in which case some of its neighbors are
+ * in other tiles: their offsets are computed and stored in `tmp'.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+inline auto
+marcher_3d<base, node, num_neighbors, queue>::get_neighborhood(
+  int i, int j, int k, neighborhood & tmp) const -> neighborhood const &
+{
+  if constexpr (is_tiled) {
+    auto const inside = [] (int p) {
+      return (unsigned) ((p & tile_mask) - 1) < (unsigned) (tile_size - 2);
+    };
+    if (inside(i + 1) && inside(j + 1) && inside(k + 1)) {
+      return _nbhd;
+    }
+
+    // Since node_index is a sum of terms for each coordinate, we only
+    // need three terms for each.
+    int const tiles_i = num_tiles(_height), tiles_j = num_tiles(_width);
+    int ti[3], tj[3], tk[3];
+    for (int d = 0; d < 3; ++d) {
+      ti[d] = tile_term(i + d, 1, 0);
+      tj[d] = tile_term(j + d, tiles_i, tile_shift);
+      tk[d] = tile_term(k + d, tiles_i*tiles_j, 2*tile_shift);
+    }
+    int const l0 = ti[1] + tj[1] + tk[1];
+    for (int c = 0; c < 27; ++c) {
+      tmp.cube[c] = ti[c % 3] + tj[(c/3) % 3] + tk[c/9] - l0;
+    }
+    tmp.cube[27] = 0;
+    for (int l = 0; l < 26; ++l) {
+      tmp.nb[l] = tmp.cube[_nb_cube_index[l]];
+    }
+    return tmp;
+  } else {
+    (void) i;
+    (void) j;
+    (void) k;
+    (void) tmp;
+    return _nbhd;
+  }
+}
+
+/**
+ * Get a mask of the valid nodes in the 3x3x3 cube centered at the
+ * node with index l: bit c of the mask is set if the node at cube
+ * index c (see __cube_index) is valid. Since di varies fastest in the
+ * node array, each of the nine columns of the cube is a run of three
+ * bits in _valid_bits, so this only takes nine (two byte) loads. This
+ * isn't true for a node on the face of a tile, whose bits are loaded
+ * one at a time.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+uint32_t marcher_3d<base, node, num_neighbors, queue>::get_valid_mask(
+  int l, neighborhood const & nbhd) const
+{
+  uint32_t mask = 0;
+  if (is_tiled && &nbhd != &_nbhd) {
+    for (int c = 0; c < 27; ++c) {
+      int pos = l + nbhd.cube[c];
+      mask |= ((_valid_bits[pos >> 3] >> (pos & 7)) & 1) << c;
+    }
+    return mask;
+  }
+  for (int c = 0; c < 9; ++c) {
+    int pos = l + nbhd.cube[3*c];
+    uint32_t bits = _valid_bits[pos >> 3] | (_valid_bits[(pos >> 3) + 1] << 8);
+    mask |= ((bits >> (pos & 7)) & 7) << 3*c;
+  }
+  return mask;
+}
+
+/**
+ * See the comment for marcher::run in marcher.impl.hpp.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::run() {
+  while (!this->_heap.empty()) {
+    marcher_3d::visit_neighbors_impl(this->get_next_node());
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::step() {
+  marcher_3d::visit_neighbors_impl(this->get_next_node());
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+double marcher_3d<base, node, num_neighbors, queue>::run_until(double bound) {
+  double value;
+  while (!this->_heap.empty()) {
+    if ((value = this->_heap.front()->get_value()) > bound) {
+      return value;
+    }
+    marcher_3d::visit_neighbors_impl(this->get_next_node());
+  }
+  return inf<double>;
+}
+
+/**
+ * Solve the eikonal equation using Gauss-Seidel fast sweeping: sweep
+ * the grid in each of the eight orderings in turn (see `sweep') until
+ * a sweep doesn't change any values, or until max_sweeps sweeps have
+ * been done, if max_sweeps > 0. Returns the number of sweeps done.
+ *
+ * Each node is updated using the same update_impl as marching, so
+ * the fixed point is the same as the marcher's solution (exactly,
+ * for RHR; MP0's and MP1's updates aren't always causal, so their
+ * solutions depend a little on the order in which nodes are
+ * accepted). How many sweeps this takes depends on how often the
+ * characteristics turn: for a smooth speed function and a point
+ * source, it's usually one or two passes through the orderings.
+ *
+ * This is meant to be used instead of `run', after adding boundary
+ * nodes: valid and barrier nodes are never updated, and all other
+ * nodes are. Unlike marching, this also uses barrier nodes with
+ * finite values (see set_barrier_value) to update their neighbors.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+int marcher_3d<base, node, num_neighbors, queue>::run_sweeps(int max_sweeps) {
+  int num_sweeps = 0, num_changed;
+  do {
+    num_changed = sweep(num_sweeps++ % 8);
+  } while (num_changed > 0 && num_sweeps != max_sweeps);
+  return num_sweeps;
+}
+
+/**
+ * Update each node of the grid once, in the ordering given by the
+ * bits of `ordering': bit 0, 1, or 2 is set if i, j, or k
+ * (respectively) should decrease during the sweep instead of
+ * increase. Returns the number of nodes whose values went down.
+ *
+ * A node is only updated if one of its neighbors changed since it was
+ * last updated (or if it hasn't been updated yet), which skips most
+ * of the nodes once the front has passed through them.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+int marcher_3d<base, node, num_neighbors, queue>::sweep(int ordering) {
+  assert(0 <= ordering && ordering < 8);
+
+  init_sweeping();
+
+  int num_changed = 0;
+  for (int k_ = 0; k_ < _depth; ++k_) {
+    int k = ordering & 4 ? _depth - 1 - k_ : k_;
+    for (int j_ = 0; j_ < _width; ++j_) {
+      int j = ordering & 2 ? _width - 1 - j_ : j_;
+      for (int i_ = 0; i_ < _height; ++i_) {
+        int i = ordering & 1 ? _height - 1 - i_ : i_;
+        int l = node_index(i, j, k);
+        if (!((_dirty_bits[l >> 3] >> (l & 7)) & 1)) continue;
+        _dirty_bits[l >> 3] &= ~(1 << (l & 7));
+        state s = get_state(l);
+        if (s == state::valid || s == state::barrier) continue;
+        num_changed += relax(i, j, k, l);
+      }
+    }
+  }
+  return num_changed;
+}
+
+/**
+ * Set the value of the barrier node at (i, j, k) (see
+ * add_barrier_node). Marching ignores this value, but sweeping uses
+ * it to update the node's neighbors (this is how parallel_marcher_3d
+ * passes values between its blocks when sweeping).
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::set_barrier_value(
+  int i, int j, int k, double value)
+{
+  assert(in_bounds(i, j, k));
+  int l = node_index(i, j, k);
+  assert(get_state(l) == state::barrier);
+  _nodes[l].set_value(value);
+  if (_dirty_bits != nullptr) {
+    mark_neighbors_dirty(i, j, k, l);
+  }
+}
+
+/**
+ * Get ready to sweep. The trial nodes left in the heap by
+ * add_boundary_node are just dropped from it: sweeping updates them
+ * like any other node, and changes their values without telling the
+ * heap.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::init_sweeping() {
+  while (!this->_heap.empty()) {
+    this->get_next_node();
+  }
+  if (_dirty_bits == nullptr) {
+    int size = node_array_size();
+    _dirty_bits = new uint8_t[size/8 + 2];
+    std::fill(_dirty_bits, _dirty_bits + size/8 + 2, 0xff);
+  }
+}
+
+/**
+ * Update the node at (i, j, k) (whose index is l0) using all of its
+ * neighbors with smaller values, and return whether its value went
+ * down.
+ *
+ * update_impl only does the updates which include the parent, and
+ * only uses the neighbors in nb_mask. To do each update once, we go
+ * through the neighbors in the order a marcher would have accepted
+ * them (i.e., sorted by value), and do the updates with each one as
+ * the parent and all of the neighbors before it in nb_mask, which is
+ * exactly what visit_neighbors_impl would have done.
+ */
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+bool marcher_3d<base, node, num_neighbors, queue>::relax(
+  int i, int j, int k, int l0)
+{
+  double const U = _nodes[l0].get_value();
+
+  neighborhood tmp;
+  auto const & nbhd = get_neighborhood(i, j, k, tmp);
+
+  // Insertion sort the neighbors with smaller values by value.
+  int order[num_neighbors], num = 0;
+  double values[num_neighbors];
+  for (int l = 0; l < num_neighbors; ++l) {
+    double value = _nodes[l0 + nbhd.nb[l]].get_value();
+    if (!(value < U)) continue;
+    int m = num++;
+    for (; m > 0 && values[m - 1] > value; --m) {
+      values[m] = values[m - 1];
+      order[m] = order[m - 1];
+    }
+    values[m] = value;
+    order[m] = l;
+  }
+  if (num == 0) {
+    return false;
+  }
+
+  node * nb[num_neighbors];
+  std::fill(nb, nb + num_neighbors, nullptr);
+  uint32_t nb_mask = 0;
+
+  static_cast<base *>(this)->s_hat = this->get_speed(i, j, k);
+
+  double T = inf<double>;
+  for (int m = 0; m < num; ++m) {
+    int l = order[m];
+    nb[l] = &_nodes[l0 + nbhd.nb[l]];
+    nb_mask |= 1 << l;
+    double T_parent = inf<double>;
+    static_cast<base *>(this)->base::update_impl(
+      i, j, k, nb, nb_mask, l, T_parent);
+    T = fmin(T, T_parent);
+  }
+
+  if (T < U) {
+#if EIKONAL_DEBUG && !RELWITHDEBINFO
+    assert(T >= 0);
+#endif
+    _nodes[l0].set_value(T);
+    mark_neighbors_dirty(i, j, k, l0);
+    return true;
+  }
+  return false;
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::mark_neighbors_dirty(
+  int i, int j, int k, int l0)
+{
+  neighborhood tmp;
+  auto const & nbhd = get_neighborhood(i, j, k, tmp);
+  for (int l = 0; l < num_neighbors; ++l) {
+    int lin = l0 + nbhd.nb[l];
+    _dirty_bits[lin >> 3] |= 1 << (lin & 7);
+  }
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::init_queue() {
+  if (_queue_initialized) {
+    return;
+  }
 
-template <class base, class node, int num_neighbors>
-void marcher_3d<base, node, num_neighbors>::visit_neighbors_impl(abstract_node * n) {
-  int i = static_cast<node *>(n)->get_i();
-  int j = static_cast<node *>(n)->get_j();
-  int k = static_cast<node *>(n)->get_k();
+  // See comment in marcher.impl.hpp.
+  double s_min = inf<double>;
+  if constexpr (is_tiled) {
+    // (The padding of the speed function cache isn't initialized.)
+    for (int k = 0; k < _depth; ++k) {
+      for (int j = 0; j < _width; ++j) {
+        for (int i = 0; i < _height; ++i) {
+          s_min = fmin(s_min, _s_cache[linear_index(i, j, k)]);
+        }
+      }
+    }
+  } else {
+    for (int l = 0; l < _height*_width*_depth; ++l) {
+      s_min = fmin(s_min, _s_cache[l]);
+    }
+  }
+  set_key_scale(this->_heap, s_min*_h);
+  _queue_initialized = true;
+}
+
+template <class base, class node, int num_neighbors,
+          template <class> class queue>
+void marcher_3d<base, node, num_neighbors, queue>::visit_neighbors_impl(node * n) {
+  int i, j, k;
+  get_index(n, i, j, k);
+  int l0 = static_cast<int>(n - _nodes);
+  set_state(l0, state::valid);
+  _valid_bits[l0 >> 3] |= 1 << (l0 & 7);
 
   // See comments in marcher.impl.hpp; the visit_neighbors_impl there
   // is done analogously to this one.
 
-  int a, b, c;
+  int lin;
+
+  neighborhood tmp;
+  auto const & nbhd = get_neighborhood(i, j, k, tmp);
 
   // Stage neighbors.
   for (int l = 0; l < num_neighbors; ++l) {
-    a = i + __di(l), b = j + __dj(l), c = k + __dk(l);
-    if (in_bounds(a, b, c) && operator()(a, b, c).is_far()) {
-      operator()(a, b, c).set_trial();
-      insert_into_heap(&operator()(a, b, c));
+    if (get_state(lin = l0 + nbhd.nb[l]) == state::far) {
+      set_state(lin, state::trial);
+      this->insert_into_heap(&_nodes[lin]);
     }
   }
 
-  // Get valid neighbors.
-  node * valid_nb[26], * child_nb[num_neighbors];
-  memset(valid_nb, 0x0, 26*sizeof(abstract_node *));
-  for (int l = 0; l < 26; ++l) {
-    a = i + __di(l), b = j + __dj(l), c = k + __dk(l);
-    if (in_bounds(a, b, c) && operator()(a, b, c).is_valid()) {
-      valid_nb[l] = &this->operator()(a, b, c);
-    }
-  }
+  // Get valid neighbors. Since n is valid, the bit for n is set in
+  // valid_mask, so the parent of each child neighborhood below is set
+  // without any special handling.
+  uint32_t valid_mask = get_valid_mask(l0, nbhd), child_mask;
+  node * child_nb[num_neighbors];
 
-  int di_l, dj_l, dk_l;
-  auto const set_child_nb = [&] (int parent) {
-    memset(child_nb, 0x0, num_neighbors*sizeof(abstract_node *));
-    child_nb[parent] = static_cast<node *>(n);
+  auto const set_child_nb = [&] (int l) {
+    child_mask = 0;
     for (int m = 0; m < num_neighbors; ++m) {
-      if (m == parent) {
-        continue;
-      }
-      int di_lm, dj_lm, dk_lm;
-      if (std::abs(di_lm = di_l + __di(m)) > 1 ||
-          std::abs(dj_lm = dj_l + __dj(m)) > 1 ||
-          std::abs(dk_lm = dk_l + __dk(m)) > 1) {
-        continue;
-      }
-      if (in_bounds(i + di_lm, j + dj_lm, k + dk_lm)) {
-        int p = d2l(di_lm, dj_lm, dk_lm);
-        child_nb[m] = valid_nb[p];
-      }
+      int c = _child_nb_cube_index[l][m];
+      uint32_t bit = (valid_mask >> c) & 1;
+      child_nb[m] = bit ? n + nbhd.cube[c] : nullptr;
+      child_mask |= bit << m;
     }
   };
 
   auto & s_hat = static_cast<base *>(this)->s_hat;
-  auto const update = [&] (int i, int j, int k, int parent) {
+  auto const solve = [&] (node * update_node, int i, int j, int k, int parent) {
     auto T = inf<double>;
-    node * update_node = &operator()(i, j, k);
     s_hat = this->get_speed(i, j, k);
-    update_impl(update_node, child_nb, parent, T);
+    static_cast<base *>(this)->base::update_impl(
+      i, j, k, child_nb, child_mask, parent, T);
 #if NODE_MONITORING
     if (update_node->monitoring_node()) {
       std::cout << *update_node << std::endl;
     }
+#else
+    (void) update_node;
 #endif
+    return T;
+  };
+
+  auto const update = [&] (int lin, int i, int j, int k, int parent) {
+    node * update_node = &_nodes[lin];
+    double T = solve(update_node, i, j, k, parent);
+    if (T < update_node->get_value()) {
+#if EIKONAL_DEBUG && !RELWITHDEBINFO
+      assert(T >= 0);
+#endif
+      update_node->set_value(T);
+      this->adjust_heap_entry(update_node);
+    }
+  };
+
+  // See allow_reopening.
+  auto const reopen = [&] (int lin, int i, int j, int k, int parent) {
+    node * update_node = &_nodes[lin];
+    double T = solve(update_node, i, j, k, parent);
     if (T < update_node->get_value()) {
 #if EIKONAL_DEBUG && !RELWITHDEBINFO
       assert(T >= 0);
 #endif
       update_node->set_value(T);
-      adjust_heap_entry(update_node);
+      set_state(lin, state::trial);
+      _valid_bits[lin >> 3] &= ~(1 << (lin & 7));
+      _late_bits[lin >> 3] |= 1 << (lin & 7);
+      this->insert_into_heap(update_node);
     }
   };
 
@@ -323,19 +1097,27 @@ void marcher_3d<base, node, num_neighbors>::visit_neighbors_impl(abstract_node *
     else return 42 - 2*(l/2) + (l % 2);
   };
 
+  bool const late = _reopening && ((_late_bits[l0 >> 3] >> (l0 & 7)) & 1);
+
   for (int l = 0; l < num_neighbors; ++l) {
-    if (!valid_nb[l]) {
-      di_l = __di(l), dj_l = __dj(l), dk_l = __dk(l);
-      a = i + di_l, b = j + dj_l, c = k + dk_l;
-      if (!in_bounds(a, b, c)) continue;
+    if (!((valid_mask >> _nb_cube_index[l]) & 1)) {
+      if (get_state(lin = l0 + nbhd.nb[l]) == state::barrier) continue;
+      int parent = get_parent(l);
+      set_child_nb(l);
+      update(lin, i + __di(l), j + __dj(l), k + __dk(l), parent);
+    } else if (late) {
+      lin = l0 + nbhd.nb[l];
+      if (_nodes[lin].get_value() <= n->get_value()) continue;
+      if ((_boundary_bits[lin >> 3] >> (lin & 7)) & 1) continue;
       int parent = get_parent(l);
-      set_child_nb(parent);
-      update(a, b, c, parent);
+      set_child_nb(l);
+      reopen(lin, i + __di(l), j + __dj(l), k + __dk(l), parent);
     }
   }
 }
 
 #undef __maxabs3
+#undef __cube_index
 
 #undef __di
 #undef __dj
@@ -21,9 +21,17 @@ void qpi_bary(double const * G, double const * c, double const * x0,
 template <class cost_functor, int n, int d, line_search L = line_search::HYBRID>
 struct sqp_bary {};
 
+/**
+ * Minimize `func' over the unit simplex using SQP, starting from
+ * `xinit' (or the centroid if `xinit' is nullptr). If `niters' is
+ * positive, at most `niters' iterations are done; if SQP hasn't
+ * converged by then, `*error' is set, and `x' and `f' are the last
+ * iterate and the value of `func' there. Returns the number of
+ * iterations that were done.
+ */
 template <class cost_functor, line_search L>
 struct sqp_bary<cost_functor, 3, 2, L> {
-  void operator()(cost_functor & func, double const * xinit,
+  int operator()(cost_functor & func, double const * xinit,
                   double * x, double * f, bool * error,
                   double tol = eps<double>, int niters = 0);
 };
@@ -16,7 +16,7 @@ inline double compute_lambda_min_symmetric<2>(double const * A) {
 }
 
 template <class cost_functor, line_search L>
-void
+int
 sqp_bary<cost_functor, 3, 2, L>::operator()(
   cost_functor & func, double const * xinit, double * x, double * f,
   bool * error, double tol, int niters)
@@ -36,6 +36,8 @@ sqp_bary<cost_functor, 3, 2, L>::operator()(
   func.eval(f1);
 
   while (true) {
+    ++k;
+
     // Compute Hessian
     func.hess(d2f);
 
@@ -102,7 +104,7 @@ sqp_bary<cost_functor, 3, 2, L>::operator()(
     }
 
     // Check if we've reached our max number of iterations
-    if (++k == niters) {
+    if (k == niters) {
       if (error) *error = true;
       break;
     }
@@ -116,6 +118,8 @@ sqp_bary<cost_functor, 3, 2, L>::operator()(
   if (f != nullptr) {
     *f = f1;
   }
+
+  return k;
 }
 
 #undef __compute_lambda_min
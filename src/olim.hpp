@@ -7,26 +7,40 @@
 #include "node.hpp"
 #include "updates.line.hpp"
 #include "updates.tri.hpp"
+#include "updates.tri_batch.hpp"
 
-template <cost_func F, class node, bool do_adj, bool do_diag>
+template <cost_func F, class node, bool do_adj, bool do_diag,
+          template <class> class queue = heap>
 struct olim:
   public marcher<
-    olim<F, node, do_adj, do_diag>,
+    olim<F, node, do_adj, do_diag, queue>,
     node,
-    do_diag ? 8 : 4>
+    do_diag ? 8 : 4,
+    queue>
 {
   static constexpr cost_func F_ = F;
   static constexpr int num_neighbors = do_diag ? 8 : 4;
 
   using node_t = node;
 
-  using marcher<olim<F, node, do_adj, do_diag>, node, num_neighbors>::marcher;
+  using marcher<
+    olim<F, node, do_adj, do_diag, queue>, node, num_neighbors, queue>::marcher;
   static_assert(do_adj || do_diag, "error");
 
   double s_hat, s[num_neighbors];
   node * nb[num_neighbors];
 
+  // The triangle updates with bit vector offsets are queued up here
+  // and solved together at the end of update_impl (olim8 does 4
+  // triangle updates between adjacent neighbors and 8 between
+  // adjacent and diagonal neighbors).
+  updates::tri_bv_batch<F, 2, do_diag ? 12 : 4> tri_batch;
+
 EIKONAL_PRIVATE:
+  // marcher calls update_impl non-virtually (see marcher::run).
+  friend struct marcher<
+    olim<F, node, do_adj, do_diag, queue>, node, num_neighbors, queue>;
+
   virtual void update_impl(node * n, double & T);
 
   template <int d>
@@ -38,15 +52,13 @@ EIKONAL_PRIVATE:
   }
 
   template <int p0, int p1>
-  inline void tri(int i, int j, double & u) {
+  inline void tri(int i, int j) {
     if (this->nb[i] && this->nb[j]) {
-      u = std::min(u, updates::tri_bv<F, 2, p0, p1>()(
+      tri_batch.template push<p0, p1>(
         this->nb[i]->get_value(), // u0
         this->nb[j]->get_value(), // u1
-        this->s_hat,              // s
         this->s[i],               // s0
-        this->s[j],               // s1
-        this->get_h()).value);    // h
+        this->s[j]);              // s1
     }
   }
 
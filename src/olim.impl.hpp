@@ -13,9 +13,10 @@
 #define P10 2
 #define P11 3
 
-template <cost_func F, class node, bool do_adj, bool do_diag>
+template <cost_func F, class node, bool do_adj, bool do_diag,
+          template <class> class queue>
 void
-olim<F, node, do_adj, do_diag>::update_impl(node * n, double & T)
+olim<F, node, do_adj, do_diag, queue>::update_impl(node * n, double & T)
 {
   int i_hat = n->get_i(), j_hat = n->get_j();
 
@@ -45,17 +46,19 @@ olim<F, node, do_adj, do_diag>::update_impl(node * n, double & T)
     }
   }
   else {
+    tri_batch.reset(s_hat, this->get_h());
     for (int a = 0, b = 1; a < 4; b = (++a + 1) % 4) {
       line<1>(a, T);
-      tri<P01, P10>(a, b, T);
+      tri<P01, P10>(a, b);
     }
     if (do_diag) {
       for (int a = 4, b = 0, c = 1; a < 8; ++a, c = (++b + 1) % 4) {
         line<2>(a, T);
-        tri<P11, P01>(a, b, T);
-        tri<P11, P10>(a, c, T);
+        tri<P11, P01>(a, b);
+        tri<P11, P10>(a, c);
       }
     }
+    T = std::min(T, tri_batch.min_value());
   }
 }
 
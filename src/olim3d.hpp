@@ -2,10 +2,14 @@
 #define __OLIM3D_HPP__
 
 #include "marcher_3d.hpp"
+#include "compact_node_3d.hpp"
 #include "node_3d.hpp"
+#include "soa_node_3d.hpp"
 #include "updates.line.hpp"
 #include "updates.tetra.hpp"
+#include "updates.tetra_batch.hpp"
 #include "updates.tri.hpp"
+#include "updates.tri_batch.hpp"
 
 // Group dependencies:
 //
@@ -38,12 +42,14 @@ struct groups_t {
     (I || II || III || IV_b ? 18 : 6);
 };
 
-template <cost_func F, class base_olim3d, class node, int num_neighbors>
+template <cost_func F, class base_olim3d, class node, int num_neighbors,
+          template <class> class queue = heap>
 struct abstract_olim3d:
   public marcher_3d<
-  abstract_olim3d<F, base_olim3d, node, num_neighbors>,
+  abstract_olim3d<F, base_olim3d, node, num_neighbors, queue>,
     node,
-    num_neighbors>
+    num_neighbors,
+    queue>
 {
   static constexpr cost_func F_ = F;
   static constexpr int num_nb = num_neighbors;
@@ -53,9 +59,10 @@ struct abstract_olim3d:
   using node_t = node;
 
   using marcher_3d_t = marcher_3d<
-    abstract_olim3d<F, base_olim3d, node, num_neighbors>,
+    abstract_olim3d<F, base_olim3d, node, num_neighbors, queue>,
     node,
-    num_neighbors>;
+    num_neighbors,
+    queue>;
 
   abstract_olim3d() { init(); }
 
@@ -63,7 +70,7 @@ struct abstract_olim3d:
                   no_speed_func_t const &):
       marcher_3d_t {height, width, depth, h, no_speed_func_t {}}
 #if COLLECT_STATS
-      , _node_stats {new updates::stats<3>[height*width*depth]}
+      , _node_stats {new updates::stats<3>[this->linear_size()]}
 #endif
   { init(); }
 
@@ -73,7 +80,7 @@ struct abstract_olim3d:
                   double x0 = 0.0, double y0 = 0.0, double z0 = 0.0):
       marcher_3d_t {height, width, depth, h, speed, x0, y0, z0}
 #if COLLECT_STATS
-      , _node_stats {new updates::stats<3>[height*width*depth]}
+      , _node_stats {new updates::stats<3>[this->linear_size()]}
 #endif
   { init(); }
 
@@ -81,15 +88,59 @@ struct abstract_olim3d:
                   double const * s_cache):
       marcher_3d_t {height, width, depth, h, s_cache}
 #if COLLECT_STATS
-      , _node_stats {new updates::stats<3>[height*width*depth]}
+      , _node_stats {new updates::stats<3>[this->linear_size()]}
+#endif
+  { init(); }
+
+  abstract_olim3d(int height, int width, int depth, double h,
+                  std::shared_ptr<double const> s_cache):
+      marcher_3d_t {height, width, depth, h, std::move(s_cache)}
+#if COLLECT_STATS
+      , _node_stats {new updates::stats<3>[this->linear_size()]}
 #endif
   { init(); }
 
   void init();
-  virtual void update_impl(node * n, node ** nb, int parent, double & T);
+  virtual void update_impl(
+    int i, int j, int k, node ** nb, uint32_t nb_mask, int parent,
+    double & T);
 
   double s_hat, s[num_neighbors];
 
+  // Bit l is set if nb[l] is valid (see marcher_3d::update_impl).
+  uint32_t nb_mask;
+
+  // The factoring center of the node being updated (or nullptr), and
+  // the offset from the node to it.
+  typename node::fac_center const * fc;
+  double p_fac[3];
+
+  // The maximum number of SQP iterations done by a tetrahedron update
+  // solved with SQP (see updates::tetra); zero means no cap. Hitting
+  // the cap isn't fatal: the update's value is then an upper bound.
+  int max_sqp_iters {0};
+
+  // Record the result of a tetrahedron update solved with SQP.
+  inline void sqp_done(int iters, bool error) {
+#if COLLECT_STATS
+    this->_stats->sqp_iters += iters;
+    this->_stats->sqp_failures += error;
+#else
+    (void) iters;
+    (void) error;
+#endif
+  }
+
+  // Record the number of root finding iterations done by one or more
+  // triangle updates.
+  inline void tri_done(int iters) {
+#if COLLECT_STATS
+    this->_stats->tri_iters += iters;
+#else
+    (void) iters;
+#endif
+  }
+
 #if COLLECT_STATS
   virtual ~abstract_olim3d() { delete[] _node_stats; }
   void dump_stats() const;
@@ -102,41 +153,113 @@ struct abstract_olim3d:
 #endif
 };
 
-template <cost_func F, class node, class groups>
+/**
+ * How olim3d_bv and olim3d_hu decide which tetrahedron updates to
+ * solve:
+ *
+ * - SOLVE_ALL: solve all of them. olim3d_bv does them before the
+ *   triangle updates, and uses their minimizers to skip the triangle
+ *   updates which can't do any better (see solve_tetra_batch).
+ *
+ * - TRIS_FIRST: do the triangle updates first, and only solve a
+ *   tetrahedron update if the KKT conditions don't hold at the
+ *   minimizer of its best face (see updates::should_skip). If they
+ *   do, that point is the tetrahedron update's minimizer, and its
+ *   value has already been accounted for.
+ *
+ * The factored updates in olim3d_bv always use SOLVE_ALL.
+ */
+enum class tetra_strategy {SOLVE_ALL, TRIS_FIRST};
+
+template <cost_func F, class node, class groups,
+          template <class> class queue = heap,
+          tetra_strategy S = tetra_strategy::SOLVE_ALL>
 struct olim3d_bv:
   public abstract_olim3d<
-    F, olim3d_bv<F, node, groups>, node, groups::num_neighbors>
+    F, olim3d_bv<F, node, groups, queue, S>, node, groups::num_neighbors,
+    queue>
 {
   static constexpr int num_neighbors = groups::num_neighbors;
 
   using abstract_olim3d<
-    F, olim3d_bv<F, node, groups>, node, num_neighbors>::abstract_olim3d;
+    F, olim3d_bv<F, node, groups, queue, S>, node, num_neighbors,
+    queue>::abstract_olim3d;
 
   void init_crtp() {}
 
-  node * n;
   node ** nb;
-  int parent, octant;
+  int parent;
   int const * inds;
-  bool tri_skip_list[42*8]; // TODO: compress
+
+  // Bit 7*m + M (where m < M are positions in `inds') is set if the
+  // triangle update (m, M) in the current octant should be skipped.
+  // For TRIS_FIRST, it's set once the triangle update has been done,
+  // and tri_infos[7*m + M] holds its result (with lambda measured
+  // from m to M).
+  uint64_t tri_skip_mask;
+  updates::info<1> tri_infos[7*6];
+
+  // The triangle updates (other than the factored ones) are collected
+  // here over all of the octants and solved together at the end of
+  // update_crtp. A parent is in at most 4 octants, each of which has
+  // 18 triangle updates.
+  updates::tri_bv_batch<F, 3, 4*18> tri_batch;
+
+  // For MP0 and RHR, the tetrahedron updates (other than the factored
+  // ones) in the current octant are collected here and solved
+  // together before doing the octant's triangle updates (see
+  // update_octant). There are 29 tetrahedron updates per octant. For
+  // each one, tetra_tris holds the skip mask bits of its three faces.
+  updates::tetra_bv_batch<F, 3, 29> tetra_batch;
+  struct face_bits {
+    uint64_t ab, bc, ac;
+  } tetra_tris[29];
 
   void update_crtp(double & T);
 
 EIKONAL_PRIVATE:
+  template <int pos>
+  void update_octant(double & T);
 
-  inline void reset_tri_skip_list() {
-    memset(tri_skip_list, 0, sizeof(tri_skip_list));
+  template <int pos>
+  void tetras(double & T);
+
+  template <int pos>
+  void tris(double & T);
+
+  template <int i, int j>
+  static constexpr int tri_index() {
+    constexpr int m = i < j ? i : j, M = i < j ? j : i;
+    return 7*m + M;
+  }
+
+  template <int i, int j>
+  static constexpr uint64_t tri_skip_bit() {
+    return uint64_t {1} << tri_index<i, j>();
   }
 
   template <int i, int j>
-  inline bool & skip_tri() {
-    int m = i < j ? i : j, M = i < j ? j : i;
-    return tri_skip_list[42*octant + 7*m + M];
+  inline bool skip_tri() const {
+    return tri_skip_mask & tri_skip_bit<i, j>();
   }
 
+  template <int i, int j>
+  inline void set_skip_tri() {
+    tri_skip_mask |= tri_skip_bit<i, j>();
+  }
+
+  // Check that all of the neighbors in `mask' are valid.
+  inline bool has_nbs(uint32_t mask) const {
+    return (this->nb_mask & mask) == mask;
+  }
+
+  // The tri and tetra updates below take the position of the parent
+  // in `inds' as their first template parameter (see update_octant),
+  // and compile to nothing if they don't include it.
+
   template <int d>
   inline void line(int i, double & u) {
-    if (this->nb[i]) {
+    if ((this->nb_mask >> i) & 1) {
       auto u_hat = updates::line_bv<F, d>()(
         this->nb[i]->get_value(), this->s_hat, this->s[i], this->get_h());
       u = std::min(u, u_hat);
@@ -146,43 +269,57 @@ EIKONAL_PRIVATE:
     }
   }
 
-  template <int a, int b, int p0, int p1>
+  template <int pos, int a, int b, int p0, int p1>
   inline void tri(double & u) {
+    if constexpr (pos != a && pos != b) {
+      return;
+    }
     if (skip_tri<a, b>()) {
       return;
     }
     int l0 = inds[a], l1 = inds[b];
-    if ((l0 == parent || l1 == parent) && nb[l0] && nb[l1]) {
-      auto info = updates::tri_bv<F, 3, p0, p1>()(
-        this->nb[l0]->get_value(),
-        this->nb[l1]->get_value(),
-        this->s_hat,
-        this->s[l0],
-        this->s[l1],
-        this->get_h());
-      u = std::min(u, info.value);
+    if (has_nbs((1u << l0) | (1u << l1))) {
+      if constexpr (S == tetra_strategy::TRIS_FIRST) {
+        auto info = updates::tri_bv<F, 3, p0, p1>()(
+          this->nb[l0]->get_value(),
+          this->nb[l1]->get_value(),
+          this->s_hat,
+          this->s[l0],
+          this->s[l1],
+          this->get_h());
+        u = std::min(u, info.value);
+        this->tri_done(info.iters);
+        if (a > b) {
+          info.lambda[0] = 1 - info.lambda[0];
+        }
+        tri_infos[tri_index<a, b>()] = info;
+      } else {
+        (void) u;
+        tri_batch.template push<p0, p1>(
+          this->nb[l0]->get_value(),
+          this->nb[l1]->get_value(),
+          this->s[l0],
+          this->s[l1]);
+      }
 #if COLLECT_STATS
       ++this->_stats->count[1];
 #endif
-      skip_tri<a, b>() = 1;
+      set_skip_tri<a, b>();
     }
   }
 
-  template <int a, int b>
+  template <int pos, int a, int b>
   inline void tri_fac(double & u) {
+    if constexpr (pos != a && pos != b) {
+      return;
+    }
     if (skip_tri<a, b>()) {
       return;
     }
     int l0 = inds[a], l1 = inds[b];
-    if ((l0 == parent || l1 == parent) && nb[l0] && nb[l1]) {
-      auto fc = n->get_fac_center();
+    if (has_nbs((1u << l0) | (1u << l1))) {
       double p0[3] = {(double)di<3>[l0], (double)dj<3>[l0], (double)dk<3>[l0]};
       double p1[3] = {(double)di<3>[l1], (double)dj<3>[l1], (double)dk<3>[l1]};
-      double p_fac[3] = {
-        (double) (fc->i - n->get_i()),
-        (double) (fc->j - n->get_j()),
-        (double) (fc->k - n->get_k())
-      };
       auto info = updates::tri<F, 3>()(
         p0,
         p1,
@@ -192,91 +329,161 @@ EIKONAL_PRIVATE:
         this->s[l0],
         this->s[l1],
         this->get_h(),
-        p_fac,
-        fc->s);
+        this->p_fac,
+        this->fc->s);
       u = std::min(u, info.value);
+      this->tri_done(info.iters);
 #if COLLECT_STATS
       ++this->_stats->count[1];
 #endif
-      skip_tri<a, b>() = 1;
+      set_skip_tri<a, b>();
     }
   }
 
-  template <int a, int b, int c, int p0, int p1, int p2>
+  template <int pos, int a, int b, int c, int p0, int p1, int p2>
   inline void tetra(double & u) {
+    if constexpr (pos != a && pos != b && pos != c) {
+      return;
+    }
     int l0 = inds[a], l1 = inds[b], l2 = inds[c];
-    if ((l0 == parent || l1 == parent || l2 == parent) &&
-        this->nb[l0] && this->nb[l1] && this->nb[l2]) {
-      updates::info<2> info;
+    if (has_nbs((1u << l0) | (1u << l1) | (1u << l2))) {
       double u0 = this->nb[l0]->get_value(), u1 = this->nb[l1]->get_value(),
         u2 = this->nb[l2]->get_value(), s = this->s_hat, s0 = this->s[l0],
         s1 = this->s[l1], s2 = this->s[l2], h = this->get_h();
-      F_wkspc<F, 2> w;
-      set_args<F>(w, u0, u1, u2, s, s0, s1, s2, h);
-      cost_functor_bv<F, 3, p0, p1, p2> func {w};
-      updates::tetra_bv<F, 3, p0, p1, p2>()(func, info);
-      bool inbounds = info.inbounds();
-      if (F == MP0 && inbounds) {
-        func.set_lambda(info.lambda);
-        eval_mp1_fix(func.w, s, s0, s1, s2, h, info.lambda, info.value);
+      if constexpr (S == tetra_strategy::TRIS_FIRST) {
+        updates::info<2> info;
+        F_wkspc<F, 2> w;
+        set_args<F>(w, u0, u1, u2, s, s0, s1, s2, h);
+        cost_functor_bv<F, 3, p0, p1, p2> func {w};
+        if (best_face<a, b, c>(info) && updates::should_skip(func, info)) {
+          return;
+        }
+        if constexpr (F == MP1) {
+          bool error;
+          int iters = updates::tetra_bv<F, 3, p0, p1, p2>(
+            this->max_sqp_iters)(func, info, &error);
+          this->sqp_done(iters, error);
+          u = std::min(u, info.value);
+        } else {
+          (void) u;
+          tetra_batch.template push<p0, p1, p2>(u0, u1, u2, s0, s1, s2);
+        }
+      } else if constexpr (F == MP1) {
+        updates::info<2> info;
+        F_wkspc<F, 2> w;
+        set_args<F>(w, u0, u1, u2, s, s0, s1, s2, h);
+        cost_functor_bv<F, 3, p0, p1, p2> func {w};
+        bool error;
+        int iters = updates::tetra_bv<F, 3, p0, p1, p2>(
+          this->max_sqp_iters)(func, info, &error);
+        this->sqp_done(iters, error);
+        u = std::min(u, info.value);
+        set_skip_tri<a, b>();
+        set_skip_tri<b, c>();
+        set_skip_tri<a, c>();
+      } else {
+        (void) u;
+        (void) s;
+        (void) h;
+        tetra_tris[tetra_batch.size()] = {
+          tri_skip_bit<a, b>(), tri_skip_bit<b, c>(), tri_skip_bit<a, c>()};
+        tetra_batch.template push<p0, p1, p2>(u0, u1, u2, s0, s1, s2);
       }
+#if COLLECT_STATS
+      ++this->_stats->count[2];
+#endif
+    }
+  }
+
+  // For TRIS_FIRST: set `info.lambda' to the minimizer of the best
+  // triangle update on a face of the tetrahedron (a, b, c), in the
+  // tetrahedron's barycentric coordinates. Returns false if none of
+  // its faces' triangle updates have been done.
+  template <int a, int b, int c>
+  inline bool best_face(updates::info<2> & info) const {
+    double value = inf<double>;
+    face<a, b, c, a, b>(info, value);
+    face<a, b, c, b, c>(info, value);
+    face<a, b, c, a, c>(info, value);
+    return value < inf<double>;
+  }
+
+  template <int a, int b, int c, int i, int j>
+  inline void face(updates::info<2> & info, double & value) const {
+    if (!skip_tri<i, j>()) {
+      return;
+    }
+    auto const & tri_info = tri_infos[tri_index<i, j>()];
+    if (tri_info.value < value) {
+      value = tri_info.value;
+      // Barycentric coordinates of the minimizer: the triangle update's
+      // lambda goes from min(i, j) to max(i, j).
+      constexpr int m = i < j ? i : j, M = i < j ? j : i;
+      double const t = tri_info.lambda[0];
+      info.lambda[0] = b == m ? 1 - t : b == M ? t : 0;
+      info.lambda[1] = c == m ? 1 - t : c == M ? t : 0;
+    }
+  }
+
+  // Solve the tetrahedron updates collected in tetra_batch, and mark
+  // the triangle updates which they make unnecessary.
+  inline void solve_tetra_batch(double & u) {
+    tetra_batch.solve();
+    for (int k = 0; k < tetra_batch.size(); ++k) {
+      auto const info = tetra_batch.get_info(k);
       u = std::min(u, info.value);
-      if (F == MP1 || inbounds) {
-        skip_tri<a, b>() = 1;
-        skip_tri<b, c>() = 1;
-        skip_tri<a, c>() = 1;
-      } else if (info.finite_lambda()) { // (F == MP0 || F == RHR) && !inbounds
+      if constexpr (S == tetra_strategy::TRIS_FIRST) {
+        continue;
+      }
+      auto const & tris = tetra_tris[k];
+      if (info.inbounds()) {
+        tri_skip_mask |= tris.ab | tris.bc | tris.ac;
+      } else if (info.finite_lambda()) {
         auto const & lam = info.lambda;
         if (lam[0] < 0 && lam[1] < 0) {
-          skip_tri<b, c>() = 1;
+          tri_skip_mask |= tris.bc;
         } else if (lam[0] + lam[1] > 1) {
           if (lam[0] > 0 && lam[1] > 0) {
-            skip_tri<a, b>() = 1;
-            skip_tri<a, c>() = 1;
+            tri_skip_mask |= tris.ab | tris.ac;
           } else if (lam[0] < 0) {
-            skip_tri<a, c>() = 1;
+            tri_skip_mask |= tris.ac;
           } else if (lam[1] < 0) {
-            skip_tri<a, b>() = 1;
+            tri_skip_mask |= tris.ab;
           }
         } else if (lam[0] < 0) {
-          skip_tri<a, b>() = 1;
-          skip_tri<b, c>() = 1;
+          tri_skip_mask |= tris.ab | tris.bc;
         } else if (lam[1] < 0) {
-          skip_tri<b, c>() = 1;
-          skip_tri<a, c>() = 1;
+          tri_skip_mask |= tris.bc | tris.ac;
         }
       }
-#if COLLECT_STATS
-      ++this->_stats->count[2];
-#endif
     }
   }
 
   // TODO: this is a mess... clean it up
-  template <int a, int b, int c>
+  template <int pos, int a, int b, int c>
   inline void tetra_fac(double & u) {
+    if constexpr (pos != a && pos != b && pos != c) {
+      return;
+    }
     int l0 = inds[a], l1 = inds[b], l2 = inds[c];
-    if ((l0 == parent || l1 == parent || l2 == parent) &&
-        this->nb[l0] && this->nb[l1] && this->nb[l2]) {
-      auto fc = n->get_fac_center();
+    if (has_nbs((1u << l0) | (1u << l1) | (1u << l2))) {
       double p0[3] = {(double)di<3>[l0], (double)dj<3>[l0], (double)dk<3>[l0]};
       double p1[3] = {(double)di<3>[l1], (double)dj<3>[l1], (double)dk<3>[l1]};
       double p2[3] = {(double)di<3>[l2], (double)dj<3>[l2], (double)dk<3>[l2]};
-      double p_fac[3] = {
-        fc->i - n->get_i(),
-        fc->j - n->get_j(),
-        fc->k - n->get_k()
-      };
       geom_fac_wkspc<2> g;
-      g.init<3>(p0, p1, p2, p_fac);
+      g.init<3>(p0, p1, p2, this->p_fac);
       double u0 = this->nb[l0]->get_value(), u1 = this->nb[l1]->get_value(),
         u2 = this->nb[l2]->get_value(), s = this->s_hat, s0 = this->s[l0],
-        s1 = this->s[l1], s2 = this->s[l2], h = this->get_h(), s_fac = fc->s;
+        s1 = this->s[l1], s2 = this->s[l2], h = this->get_h(),
+        s_fac = this->fc->s;
       F_fac_wkspc<F, 2> w;
       set_args<F>(w, g, u0, u1, u2, s, s0, s1, s2, h, s_fac);
       cost_functor_fac<F, 3, 2> func {w, g};
       updates::info<2> info;
-      updates::tetra<F, 3>()(func, info);
+      bool error;
+      int iters = updates::tetra<F, 3>(this->max_sqp_iters)(
+        func, info, &error);
+      this->sqp_done(iters, error);
       if (F == MP0) {
         eval_mp1_fix(func.w, s, s0, s1, s2, h, info.lambda, info.value);
       }
@@ -284,16 +491,19 @@ EIKONAL_PRIVATE:
 #if COLLECT_STATS
       ++this->_stats->count[2];
 #endif
-      skip_tri<a, b>() = 1;
-      skip_tri<b, c>() = 1;
-      skip_tri<a, c>() = 1;
+      set_skip_tri<a, b>();
+      set_skip_tri<b, c>();
+      set_skip_tri<a, c>();
     }
   }
 };
 
-template <class groups> using olim3d_mp0 = olim3d_bv<MP0, node_3d, groups>;
-template <class groups> using olim3d_mp1 = olim3d_bv<MP1, node_3d, groups>;
-template <class groups> using olim3d_rhr = olim3d_bv<RHR, node_3d, groups>;
+template <class groups, template <class> class queue = heap>
+using olim3d_mp0 = olim3d_bv<MP0, node_3d, groups, queue>;
+template <class groups, template <class> class queue = heap>
+using olim3d_mp1 = olim3d_bv<MP1, node_3d, groups, queue>;
+template <class groups, template <class> class queue = heap>
+using olim3d_rhr = olim3d_bv<RHR, node_3d, groups, queue>;
 
 using olim6_groups = groups_t<0, 0, 0, 1, 0, 0, 0, 0>;
 using olim6_mp0 = olim3d_mp0<olim6_groups>;
@@ -310,11 +520,112 @@ using olim26_mp0 = olim3d_mp0<olim26_groups>;
 using olim26_mp1 = olim3d_mp1<olim26_groups>;
 using olim26_rhr = olim3d_rhr<olim26_groups>;
 
+// The same marchers using compact_node_3d (see compact_node_3d.hpp).
+using olim6_mp0_compact = olim3d_bv<MP0, compact_node_3d, olim6_groups>;
+using olim6_mp1_compact = olim3d_bv<MP1, compact_node_3d, olim6_groups>;
+using olim6_rhr_compact = olim3d_bv<RHR, compact_node_3d, olim6_groups>;
+using olim18_mp0_compact = olim3d_bv<MP0, compact_node_3d, olim18_groups>;
+using olim18_mp1_compact = olim3d_bv<MP1, compact_node_3d, olim18_groups>;
+using olim18_rhr_compact = olim3d_bv<RHR, compact_node_3d, olim18_groups>;
+using olim26_mp0_compact = olim3d_bv<MP0, compact_node_3d, olim26_groups>;
+using olim26_mp1_compact = olim3d_bv<MP1, compact_node_3d, olim26_groups>;
+using olim26_rhr_compact = olim3d_bv<RHR, compact_node_3d, olim26_groups>;
+
+// ... and storing values and speeds in single precision.
+using olim6_mp0_float = olim3d_bv<MP0, compact_float_node_3d, olim6_groups>;
+using olim6_mp1_float = olim3d_bv<MP1, compact_float_node_3d, olim6_groups>;
+using olim6_rhr_float = olim3d_bv<RHR, compact_float_node_3d, olim6_groups>;
+using olim18_mp0_float = olim3d_bv<MP0, compact_float_node_3d, olim18_groups>;
+using olim18_mp1_float = olim3d_bv<MP1, compact_float_node_3d, olim18_groups>;
+using olim18_rhr_float = olim3d_bv<RHR, compact_float_node_3d, olim18_groups>;
+using olim26_mp0_float = olim3d_bv<MP0, compact_float_node_3d, olim26_groups>;
+using olim26_mp1_float = olim3d_bv<MP1, compact_float_node_3d, olim26_groups>;
+using olim26_rhr_float = olim3d_bv<RHR, compact_float_node_3d, olim26_groups>;
+
+// ... and doing the triangle updates first (see tetra_strategy).
+using olim6_mp0_tris_first = olim3d_bv<
+  MP0, node_3d, olim6_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim6_mp1_tris_first = olim3d_bv<
+  MP1, node_3d, olim6_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim6_rhr_tris_first = olim3d_bv<
+  RHR, node_3d, olim6_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim18_mp0_tris_first = olim3d_bv<
+  MP0, node_3d, olim18_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim18_mp1_tris_first = olim3d_bv<
+  MP1, node_3d, olim18_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim18_rhr_tris_first = olim3d_bv<
+  RHR, node_3d, olim18_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim26_mp0_tris_first = olim3d_bv<
+  MP0, node_3d, olim26_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim26_mp1_tris_first = olim3d_bv<
+  MP1, node_3d, olim26_groups, heap, tetra_strategy::TRIS_FIRST>;
+using olim26_rhr_tris_first = olim3d_bv<
+  RHR, node_3d, olim26_groups, heap, tetra_strategy::TRIS_FIRST>;
+
 enum LP_NORM {L1, L2, MAX};
 
-template <cost_func F, class node, int lp_norm, int d1, int d2>
+/**
+ * The geometry of each of olim3d_hu's tetrahedron updates (indexed by
+ * hu_geometry::linear_index), and whether its three offsets are
+ * coplanar. None of this depends on the marcher, so it's computed
+ * once, the first time it's needed, and shared by all of them.
+ */
+struct hu_geometry
+{
+  static hu_geometry const & get() {
+    static hu_geometry const geometry;
+    return geometry;
+  }
+
+  static inline int linear_index(int l0, int l1, int l2) {
+    return 26*(26*l0 + l1) + l2;
+  }
+
+  bool coplanar[26*26*26];
+  geom_wkspc<2> geom_wkspcs[26*26*26];
+  qr_wkspc<3, 2> qr_wkspcs[26*26*26];
+
+EIKONAL_PRIVATE:
+  hu_geometry();
+};
+
+/**
+ * Which pairs of offsets olim3d_hu<F, node, lp_norm, d1, d2> considers
+ * for its triangle updates (valid_d1) and tetrahedron updates
+ * (valid_d2), and the resulting candidates for each update, as bit
+ * masks over the 26 neighbors:
+ *
+ * - bit l of tri_cands[l0] is set if (l0, l) is a triangle update,
+ *
+ * - bit l2 of tetra_cands[26*l0 + l1] is set if (l0, l1, l2) is a
+ *   tetrahedron update, i.e., p2 is near p0 and p1 and the three
+ *   offsets aren't coplanar.
+ *
+ * ANDing these with the marcher's nb_mask leaves exactly the updates
+ * to do. Like hu_geometry, this is shared by all marchers with the
+ * same parameters.
+ */
+template <int lp_norm, int d1, int d2>
+struct hu_candidates
+{
+  static hu_candidates const & get() {
+    static hu_candidates const candidates;
+    return candidates;
+  }
+
+  bool valid_d1[26*26], valid_d2[26*26];
+  uint32_t tri_cands[26], tetra_cands[26*26];
+
+EIKONAL_PRIVATE:
+  hu_candidates();
+};
+
+template <cost_func F, class node, int lp_norm, int d1, int d2,
+          template <class> class queue = heap,
+          tetra_strategy S = tetra_strategy::SOLVE_ALL>
 struct olim3d_hu:
-  public abstract_olim3d<F, olim3d_hu<F, node, lp_norm, d1, d2>, node, 26>
+  public abstract_olim3d<
+    F, olim3d_hu<F, node, lp_norm, d1, d2, queue, S>, node, 26, queue>
 {
   static_assert(lp_norm == L1 || lp_norm == L2 || lp_norm == MAX,
                 "Bad choice of lp norm: must be L1, L2, or MAX");
@@ -322,25 +633,16 @@ struct olim3d_hu:
   static_assert(1 <= d2 && d2 <= 3, "d2 must satisfy 1 <= d2 <= 3");
 
   using abstract_olim3d<
-    F, olim3d_hu<F, node, lp_norm, d1, d2>, node, 26>::abstract_olim3d;
-
-  ~olim3d_hu() {
-    delete[] valid_d1;
-    delete[] valid_d2;
-    delete[] coplanar;
-    delete[] geom_wkspcs;
-    delete[] qr_wkspcs;
-  }
+    F, olim3d_hu<F, node, lp_norm, d1, d2, queue, S>, node, 26,
+    queue>::abstract_olim3d;
 
   void init_crtp();
 
-  node * n;
   node ** nb;
   int parent;
-  bool * valid_d1, * valid_d2, * coplanar;
-  geom_wkspc<2> * geom_wkspcs;
-  qr_wkspc<3, 2> * qr_wkspcs;
-  double p0[3], p1[3], p2[3], p_fac[3];
+  hu_candidates<lp_norm, d1, d2> const * candidates;
+  hu_geometry const * geometry;
+  double p0[3], p1[3], p2[3];
 
   inline void get_p(int l, double * p) const {
     p[0] = di<3>[l];
@@ -354,20 +656,20 @@ struct olim3d_hu:
     else return sqrt3;
   };
 
-  inline bool & is_valid_d1(int l0, int l1) {
-    return valid_d1[26*l0 + l1];
+  inline bool is_valid_d1(int l0, int l1) const {
+    return candidates->valid_d1[26*l0 + l1];
   }
 
-  inline bool & is_valid_d2(int l0, int l1) {
-    return valid_d2[26*l0 + l1];
+  inline bool is_valid_d2(int l0, int l1) const {
+    return candidates->valid_d2[26*l0 + l1];
   }
 
   inline int linear_index(int l0, int l1, int l2) const {
-    return 26*(26*l0 + l1) + l2;
+    return hu_geometry::linear_index(l0, l1, l2);
   }
 
-  inline bool & is_coplanar(int l0, int l1, int l2) {
-    return coplanar[linear_index(l0, l1, l2)];
+  inline bool is_coplanar(int l0, int l1, int l2) const {
+    return geometry->coplanar[linear_index(l0, l1, l2)];
   }
 
   void update_crtp(double & T);
@@ -377,6 +679,21 @@ using olim3d_hu_rhr = olim3d_hu<RHR, node_3d, L1, 1, 2>;
 using olim3d_hu_mp0 = olim3d_hu<MP0, node_3d, L1, 1, 2>;
 using olim3d_hu_mp1 = olim3d_hu<MP1, node_3d, L1, 1, 2>;
 
+using olim3d_hu_rhr_compact = olim3d_hu<RHR, compact_node_3d, L1, 1, 2>;
+using olim3d_hu_mp0_compact = olim3d_hu<MP0, compact_node_3d, L1, 1, 2>;
+using olim3d_hu_mp1_compact = olim3d_hu<MP1, compact_node_3d, L1, 1, 2>;
+
+using olim3d_hu_rhr_float = olim3d_hu<RHR, compact_float_node_3d, L1, 1, 2>;
+using olim3d_hu_mp0_float = olim3d_hu<MP0, compact_float_node_3d, L1, 1, 2>;
+using olim3d_hu_mp1_float = olim3d_hu<MP1, compact_float_node_3d, L1, 1, 2>;
+
+using olim3d_hu_rhr_tris_first = olim3d_hu<
+  RHR, node_3d, L1, 1, 2, heap, tetra_strategy::TRIS_FIRST>;
+using olim3d_hu_mp0_tris_first = olim3d_hu<
+  MP0, node_3d, L1, 1, 2, heap, tetra_strategy::TRIS_FIRST>;
+using olim3d_hu_mp1_tris_first = olim3d_hu<
+  MP1, node_3d, L1, 1, 2, heap, tetra_strategy::TRIS_FIRST>;
+
 #include "olim3d.impl.hpp"
 
 #endif // __OLIM3D_HPP__
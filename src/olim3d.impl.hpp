@@ -54,6 +54,35 @@ constexpr int oct2inds[8][7] = {
   {ind::U, ind::UN, ind::N, ind::NW, ind::W, ind::UW, ind::UNW}
 };
 
+/**
+ * For each neighbor index, the octants which contain it, along with
+ * its position in oct2inds[octant] for each of these octants. This is
+ * used by olim3d_bv::update_crtp to only look at the octants
+ * containing the parent.
+ */
+struct parent_octant_table {
+  struct entry {
+    int num_octants;
+    int octants[4];
+    int positions[4];
+  } parents[26];
+};
+
+constexpr parent_octant_table make_parent_octant_table() {
+  parent_octant_table table {};
+  for (int octant = 0; octant < 8; ++octant) {
+    for (int pos = 0; pos < 7; ++pos) {
+      auto & entry = table.parents[oct2inds[octant][pos]];
+      entry.octants[entry.num_octants] = octant;
+      entry.positions[entry.num_octants] = pos;
+      ++entry.num_octants;
+    }
+  }
+  return table;
+}
+
+constexpr parent_octant_table parent_octants = make_parent_octant_table();
+
 #define P001 1
 #define P010 2
 #define P011 3
@@ -62,15 +91,17 @@ constexpr int oct2inds[8][7] = {
 #define P110 6
 #define P111 7
 
-template <cost_func F, class base, class node, int num_neighbors>
-void abstract_olim3d<F, base, node, num_neighbors>::init()
+template <cost_func F, class base, class node, int num_neighbors,
+          template <class> class queue>
+void abstract_olim3d<F, base, node, num_neighbors, queue>::init()
 {
   static_cast<base *>(this)->init_crtp();
 }
 
 #if COLLECT_STATS
-template <class base, class node, int num_neighbors>
-void abstract_olim3d<base, node, num_neighbors>::dump_stats() const
+template <cost_func F, class base, class node, int num_neighbors,
+          template <class> class queue>
+void abstract_olim3d<F, base, node, num_neighbors, queue>::dump_stats() const
 {
   printf("depth = %d, width = %d, height = %d\n", this->get_depth(),
          this->get_width(), this->get_height());
@@ -78,16 +109,19 @@ void abstract_olim3d<base, node, num_neighbors>::dump_stats() const
     for (int j = 0; j < this->get_width(); ++j) {
       for (int i = 0; i < this->get_height(); ++i) {
         auto stats = this->get_stats(i, j, k);
-        printf("%d, %d, %d: visits = %d, line = %d, tri = %d, tetra = %d\n",
+        printf("%d, %d, %d: visits = %d, line = %d, tri = %d, tetra = %d, "
+               "sqp iters = %d, sqp failures = %d, tri iters = %d\n",
                i, j, k, stats->num_visits, stats->count[0], stats->count[1],
-               stats->count[2]);
+               stats->count[2], stats->sqp_iters, stats->sqp_failures,
+               stats->tri_iters);
       }
     }
   }
 }
 
-template <class base, class node, int num_neighbors>
-void abstract_olim3d<base, node, num_neighbors>::write_stats_bin(
+template <cost_func F, class base, class node, int num_neighbors,
+          template <class> class queue>
+void abstract_olim3d<F, base, node, num_neighbors, queue>::write_stats_bin(
   const char * path) const
 {
   FILE * f = fopen(path, "wb");
@@ -108,30 +142,39 @@ void abstract_olim3d<base, node, num_neighbors>::write_stats_bin(
 }
 #endif // COLLECT_STATS
 
-template <cost_func F, class base, class node, int num_neighbors>
-void abstract_olim3d<F, base, node, num_neighbors>::update_impl(
-  node * n, node ** nb, int parent, double & T)
+template <cost_func F, class base, class node, int num_neighbors,
+          template <class> class queue>
+void abstract_olim3d<F, base, node, num_neighbors, queue>::update_impl(
+  int i, int j, int k, node ** nb, uint32_t nb_mask, int parent,
+  double & T)
 {
-  int i = n->get_i(), j = n->get_j(), k = n->get_k();
 #if COLLECT_STATS
   this->_stats = this->get_stats(i, j, k);
   ++this->_stats->num_visits;
 #endif
 
   for (int l = 0; l < num_neighbors; ++l) {
-    if (nb[l]) {
+    if ((nb_mask >> l) & 1) {
       this->s[l] = this->get_speed(i + di<3>[l], j + dj<3>[l], k + dk<3>[l]);
     }
   }
 
-  static_cast<base *>(this)->n = n;
+  fc = this->get_fac_center(this->node_index(i, j, k));
+  if (fc) {
+    p_fac[0] = fc->i - i;
+    p_fac[1] = fc->j - j;
+    p_fac[2] = fc->k - k;
+  }
+
+  this->nb_mask = nb_mask;
   static_cast<base *>(this)->nb = nb;
   static_cast<base *>(this)->parent = parent;
   static_cast<base *>(this)->update_crtp(T);
 }
 
-template <cost_func F, class node, class groups>
-void olim3d_bv<F, node, groups>::update_crtp(double & T)
+template <cost_func F, class node, class groups,
+          template <class> class queue, tetra_strategy S>
+void olim3d_bv<F, node, groups, queue, S>::update_crtp(double & T)
 {
   using std::min;
 
@@ -156,205 +199,292 @@ void olim3d_bv<F, node, groups>::update_crtp(double & T)
   }
 
   /**
-   * This array is used to keep track of which triangle updates should
-   * be skipped.
+   * Every tetrahedron and triangle update includes the parent, so we
+   * only need to look at the octants which contain it (4, 2, or 1
+   * octants for a parent of degree 1, 2, or 3). Since the triangle
+   * skip list is kept per octant, doing the octants one after the
+   * other (tetrahedra first) gives the same result as doing all of
+   * the tetrahedron updates and then all of the triangle updates.
    *
-   * TODO: we could use a bitvector here instead.
+   * The triangle updates with bit vector offsets are only queued up
+   * in tri_batch while visiting the octants, and are solved together
+   * afterwards (see updates.tri_batch.hpp).
    */
-  reset_tri_skip_list();
+  tri_batch.reset(this->s_hat, this->get_h());
+
+  auto const & octs = parent_octants.parents[parent];
+  for (int m = 0; m < octs.num_octants; ++m) {
+    inds = oct2inds[octs.octants[m]];
+    switch (octs.positions[m]) {
+    case 0: update_octant<0>(T); break;
+    case 1: update_octant<1>(T); break;
+    case 2: update_octant<2>(T); break;
+    case 3: update_octant<3>(T); break;
+    case 4: update_octant<4>(T); break;
+    case 5: update_octant<5>(T); break;
+    case 6: update_octant<6>(T); break;
+    default: assert(false);
+    }
+  }
+
+  T = min(T, tri_batch.min_value());
+  this->tri_done(tri_batch.iters());
+}
+
+/**
+ * Do the tetrahedron and then the triangle updates in the current
+ * octant (or the other way around for TRIS_FIRST), where `pos' is
+ * the position of the parent in `inds'. Only
+ * the updates which include `pos' are instantiated (see `tri' and
+ * `tetra' in olim3d.hpp).
+ */
+template <cost_func F, class node, class groups,
+          template <class> class queue, tetra_strategy S>
+template <int pos>
+void olim3d_bv<F, node, groups, queue, S>::update_octant(double & T)
+{
+  tri_skip_mask = 0;
 
-  if (n->is_factored()) {
+  if (this->fc) {
     /**
      * Tetrahedron updates:
      */
-    // TODO: decide which octants to do based on the parent index
-    // (only need to look at 1, 2, or 4 octants, never more than that)
-    for (octant = 0; octant < 8; ++octant) {
-      inds = oct2inds[octant];
-      if (groups::group_I) {
-        tetra_fac<1, 2, 3>(T);
-        tetra_fac<3, 4, 5>(T);
-        tetra_fac<5, 0, 1>(T);
-      }
-      if (groups::group_II) {
-        tetra_fac<0, 1, 3>(T);
-        tetra_fac<1, 2, 4>(T);
-        tetra_fac<2, 3, 5>(T);
-        tetra_fac<3, 4, 0>(T);
-        tetra_fac<4, 5, 1>(T);
-        tetra_fac<5, 0, 2>(T);
-      }
-      if (groups::group_III) {
-        tetra_fac<0, 1, 4>(T);
-        tetra_fac<1, 2, 5>(T);
-        tetra_fac<2, 3, 0>(T);
-        tetra_fac<3, 4, 1>(T);
-        tetra_fac<4, 5, 2>(T);
-        tetra_fac<5, 0, 3>(T);
-      }
-      if (groups::group_IV_a) {
-        tetra_fac<0, 2, 4>(T);
-      }
-      if (groups::group_IV_b) {
-        tetra_fac<1, 3, 5>(T);
-      }
-      if (groups::group_V) {
-        tetra_fac<0, 1, 6>(T);
-        tetra_fac<1, 2, 6>(T);
-        tetra_fac<2, 3, 6>(T);
-        tetra_fac<3, 4, 6>(T);
-        tetra_fac<4, 5, 6>(T);
-        tetra_fac<5, 0, 6>(T);
-      }
-      if (groups::group_VI_a) {
-        tetra_fac<0, 2, 6>(T);
-        tetra_fac<2, 4, 6>(T);
-        tetra_fac<4, 0, 6>(T);
-      }
-      if (groups::group_VI_b) {
-        tetra_fac<1, 3, 6>(T);
-        tetra_fac<3, 5, 6>(T);
-        tetra_fac<5, 1, 6>(T);
-      }
+    if (groups::group_I) {
+      tetra_fac<pos, 1, 2, 3>(T);
+      tetra_fac<pos, 3, 4, 5>(T);
+      tetra_fac<pos, 5, 0, 1>(T);
+    }
+    if (groups::group_II) {
+      tetra_fac<pos, 0, 1, 3>(T);
+      tetra_fac<pos, 1, 2, 4>(T);
+      tetra_fac<pos, 2, 3, 5>(T);
+      tetra_fac<pos, 3, 4, 0>(T);
+      tetra_fac<pos, 4, 5, 1>(T);
+      tetra_fac<pos, 5, 0, 2>(T);
+    }
+    if (groups::group_III) {
+      tetra_fac<pos, 0, 1, 4>(T);
+      tetra_fac<pos, 1, 2, 5>(T);
+      tetra_fac<pos, 2, 3, 0>(T);
+      tetra_fac<pos, 3, 4, 1>(T);
+      tetra_fac<pos, 4, 5, 2>(T);
+      tetra_fac<pos, 5, 0, 3>(T);
+    }
+    if (groups::group_IV_a) {
+      tetra_fac<pos, 0, 2, 4>(T);
+    }
+    if (groups::group_IV_b) {
+      tetra_fac<pos, 1, 3, 5>(T);
+    }
+    if (groups::group_V) {
+      tetra_fac<pos, 0, 1, 6>(T);
+      tetra_fac<pos, 1, 2, 6>(T);
+      tetra_fac<pos, 2, 3, 6>(T);
+      tetra_fac<pos, 3, 4, 6>(T);
+      tetra_fac<pos, 4, 5, 6>(T);
+      tetra_fac<pos, 5, 0, 6>(T);
+    }
+    if (groups::group_VI_a) {
+      tetra_fac<pos, 0, 2, 6>(T);
+      tetra_fac<pos, 2, 4, 6>(T);
+      tetra_fac<pos, 4, 0, 6>(T);
+    }
+    if (groups::group_VI_b) {
+      tetra_fac<pos, 1, 3, 6>(T);
+      tetra_fac<pos, 3, 5, 6>(T);
+      tetra_fac<pos, 5, 1, 6>(T);
     }
 
     /**
      * Triangle updates:
      */
-    for (octant = 0; octant < 8; ++octant) {
-      inds = oct2inds[octant];
-      if (groups::do_tri11_updates) {
-        tri_fac<0, 2>(T);
-        tri_fac<2, 4>(T);
-        tri_fac<4, 0>(T);
-      }
-      if (groups::do_tri12_updates) {
-        tri_fac<0, 1>(T);
-        tri_fac<2, 1>(T);
-        tri_fac<2, 3>(T);
-        tri_fac<4, 3>(T);
-        tri_fac<4, 5>(T);
-        tri_fac<0, 5>(T);
-      }
-      if (groups::do_tri13_updates) {
-        tri_fac<0, 6>(T);
-        tri_fac<2, 6>(T);
-        tri_fac<4, 6>(T);
-      }
-      if (groups::do_tri22_updates) {
-        tri_fac<1, 3>(T);
-        tri_fac<3, 5>(T);
-        tri_fac<5, 1>(T);
-      }
-      if (groups::do_tri23_updates) {
-        tri_fac<1, 6>(T);
-        tri_fac<3, 6>(T);
-        tri_fac<5, 6>(T);
-      }
+    if (groups::do_tri11_updates) {
+      tri_fac<pos, 0, 2>(T);
+      tri_fac<pos, 2, 4>(T);
+      tri_fac<pos, 4, 0>(T);
+    }
+    if (groups::do_tri12_updates) {
+      tri_fac<pos, 0, 1>(T);
+      tri_fac<pos, 2, 1>(T);
+      tri_fac<pos, 2, 3>(T);
+      tri_fac<pos, 4, 3>(T);
+      tri_fac<pos, 4, 5>(T);
+      tri_fac<pos, 0, 5>(T);
+    }
+    if (groups::do_tri13_updates) {
+      tri_fac<pos, 0, 6>(T);
+      tri_fac<pos, 2, 6>(T);
+      tri_fac<pos, 4, 6>(T);
+    }
+    if (groups::do_tri22_updates) {
+      tri_fac<pos, 1, 3>(T);
+      tri_fac<pos, 3, 5>(T);
+      tri_fac<pos, 5, 1>(T);
+    }
+    if (groups::do_tri23_updates) {
+      tri_fac<pos, 1, 6>(T);
+      tri_fac<pos, 3, 6>(T);
+      tri_fac<pos, 5, 6>(T);
+    }
+  }
+  else if (S == tetra_strategy::TRIS_FIRST) {
+    // For MP0 and RHR, the tetrahedron updates which need to be solved
+    // are collected in tetra_batch, as below.
+    if (F != MP1) {
+      tetra_batch.reset(this->s_hat, this->get_h());
+    }
+    tris<pos>(T);
+    tetras<pos>(T);
+    if (F != MP1) {
+      solve_tetra_batch(T);
     }
   }
   else {
-    /**
-     * Tetrahedron updates:
-     */
-    for (octant = 0; octant < 8; ++octant) {
-      inds = oct2inds[octant];
-      if (groups::group_I) {
-        tetra<1, 2, 3, P011, P010, P110>(T);
-        tetra<3, 4, 5, P110, P100, P101>(T);
-        tetra<5, 0, 1, P101, P001, P011>(T);
-      }
-      if (groups::group_II) {
-        tetra<0, 1, 3, P001, P011, P110>(T);
-        tetra<1, 2, 4, P011, P010, P100>(T);
-        tetra<2, 3, 5, P010, P110, P101>(T);
-        tetra<3, 4, 0, P110, P100, P001>(T);
-        tetra<4, 5, 1, P100, P101, P011>(T);
-        tetra<5, 0, 2, P101, P001, P010>(T);
-      }
-      if (groups::group_III) {
-        tetra<0, 1, 4, P001, P011, P100>(T);
-        tetra<1, 2, 5, P011, P010, P101>(T);
-        tetra<2, 3, 0, P010, P110, P001>(T);
-        tetra<3, 4, 1, P110, P100, P011>(T);
-        tetra<4, 5, 2, P100, P101, P010>(T);
-        tetra<5, 0, 3, P101, P001, P110>(T);
-      }
-      if (groups::group_IV_a) {
-        tetra<0, 2, 4, P001, P010, P100>(T);
-      }
-      if (groups::group_IV_b) {
-        tetra<1, 3, 5, P011, P110, P101>(T);
-      }
-      if (groups::group_V) {
-        tetra<0, 1, 6, P001, P011, P111>(T);
-        tetra<1, 2, 6, P011, P010, P111>(T);
-        tetra<2, 3, 6, P010, P110, P111>(T);
-        tetra<3, 4, 6, P110, P100, P111>(T);
-        tetra<4, 5, 6, P100, P101, P111>(T);
-        tetra<5, 0, 6, P101, P001, P111>(T);
-      }
-      if (groups::group_VI_a) {
-        tetra<0, 2, 6, P001, P010, P111>(T);
-        tetra<2, 4, 6, P010, P100, P111>(T);
-        tetra<4, 0, 6, P100, P001, P111>(T);
-      }
-      if (groups::group_VI_b) {
-        tetra<1, 3, 6, P011, P110, P111>(T);
-        tetra<3, 5, 6, P110, P101, P111>(T);
-        tetra<5, 1, 6, P101, P011, P111>(T);
-      }
+    // For MP0 and RHR, the tetrahedron updates are only collected in
+    // tetra_batch, and solved afterwards.
+    if (F != MP1) {
+      tetra_batch.reset(this->s_hat, this->get_h());
+    }
+    tetras<pos>(T);
+    if (F != MP1) {
+      solve_tetra_batch(T);
     }
+    tris<pos>(T);
+  }
+}
 
-    /**
-     * Triangle updates:
-     */
-    for (octant = 0; octant < 8; ++octant) {
-      inds = oct2inds[octant];
-      if (groups::do_tri11_updates) {
-        tri<0, 2, P001, P010>(T);
-        tri<2, 4, P010, P100>(T);
-        tri<4, 0, P100, P001>(T);
-      }
-      if (groups::do_tri12_updates) {
-        tri<0, 1, P001, P011>(T);
-        tri<2, 1, P010, P011>(T);
-        tri<2, 3, P010, P110>(T);
-        tri<4, 3, P100, P110>(T);
-        tri<4, 5, P100, P101>(T);
-        tri<0, 5, P001, P101>(T);
-      }
-      if (groups::do_tri13_updates) {
-        tri<0, 6, P001, P111>(T);
-        tri<2, 6, P010, P111>(T);
-        tri<4, 6, P100, P111>(T);
-      }
-      if (groups::do_tri22_updates) {
-        tri<1, 3, P011, P110>(T);
-        tri<3, 5, P110, P101>(T);
-        tri<5, 1, P101, P011>(T);
-      }
-      if (groups::do_tri23_updates) {
-        tri<1, 6, P011, P111>(T);
-        tri<3, 6, P110, P111>(T);
-        tri<5, 6, P101, P111>(T);
+template <cost_func F, class node, class groups,
+          template <class> class queue, tetra_strategy S>
+template <int pos>
+void olim3d_bv<F, node, groups, queue, S>::tetras(double & T)
+{
+  if (groups::group_I) {
+    tetra<pos, 1, 2, 3, P011, P010, P110>(T);
+    tetra<pos, 3, 4, 5, P110, P100, P101>(T);
+    tetra<pos, 5, 0, 1, P101, P001, P011>(T);
+  }
+  if (groups::group_II) {
+    tetra<pos, 0, 1, 3, P001, P011, P110>(T);
+    tetra<pos, 1, 2, 4, P011, P010, P100>(T);
+    tetra<pos, 2, 3, 5, P010, P110, P101>(T);
+    tetra<pos, 3, 4, 0, P110, P100, P001>(T);
+    tetra<pos, 4, 5, 1, P100, P101, P011>(T);
+    tetra<pos, 5, 0, 2, P101, P001, P010>(T);
+  }
+  if (groups::group_III) {
+    tetra<pos, 0, 1, 4, P001, P011, P100>(T);
+    tetra<pos, 1, 2, 5, P011, P010, P101>(T);
+    tetra<pos, 2, 3, 0, P010, P110, P001>(T);
+    tetra<pos, 3, 4, 1, P110, P100, P011>(T);
+    tetra<pos, 4, 5, 2, P100, P101, P010>(T);
+    tetra<pos, 5, 0, 3, P101, P001, P110>(T);
+  }
+  if (groups::group_IV_a) {
+    tetra<pos, 0, 2, 4, P001, P010, P100>(T);
+  }
+  if (groups::group_IV_b) {
+    tetra<pos, 1, 3, 5, P011, P110, P101>(T);
+  }
+  if (groups::group_V) {
+    tetra<pos, 0, 1, 6, P001, P011, P111>(T);
+    tetra<pos, 1, 2, 6, P011, P010, P111>(T);
+    tetra<pos, 2, 3, 6, P010, P110, P111>(T);
+    tetra<pos, 3, 4, 6, P110, P100, P111>(T);
+    tetra<pos, 4, 5, 6, P100, P101, P111>(T);
+    tetra<pos, 5, 0, 6, P101, P001, P111>(T);
+  }
+  if (groups::group_VI_a) {
+    tetra<pos, 0, 2, 6, P001, P010, P111>(T);
+    tetra<pos, 2, 4, 6, P010, P100, P111>(T);
+    tetra<pos, 4, 0, 6, P100, P001, P111>(T);
+  }
+  if (groups::group_VI_b) {
+    tetra<pos, 1, 3, 6, P011, P110, P111>(T);
+    tetra<pos, 3, 5, 6, P110, P101, P111>(T);
+    tetra<pos, 5, 1, 6, P101, P011, P111>(T);
+  }
+}
+
+template <cost_func F, class node, class groups,
+          template <class> class queue, tetra_strategy S>
+template <int pos>
+void olim3d_bv<F, node, groups, queue, S>::tris(double & T)
+{
+  if (groups::do_tri11_updates) {
+    tri<pos, 0, 2, P001, P010>(T);
+    tri<pos, 2, 4, P010, P100>(T);
+    tri<pos, 4, 0, P100, P001>(T);
+  }
+  if (groups::do_tri12_updates) {
+    tri<pos, 0, 1, P001, P011>(T);
+    tri<pos, 2, 1, P010, P011>(T);
+    tri<pos, 2, 3, P010, P110>(T);
+    tri<pos, 4, 3, P100, P110>(T);
+    tri<pos, 4, 5, P100, P101>(T);
+    tri<pos, 0, 5, P001, P101>(T);
+  }
+  if (groups::do_tri13_updates) {
+    tri<pos, 0, 6, P001, P111>(T);
+    tri<pos, 2, 6, P010, P111>(T);
+    tri<pos, 4, 6, P100, P111>(T);
+  }
+  if (groups::do_tri22_updates) {
+    tri<pos, 1, 3, P011, P110>(T);
+    tri<pos, 3, 5, P110, P101>(T);
+    tri<pos, 5, 1, P101, P011>(T);
+  }
+  if (groups::do_tri23_updates) {
+    tri<pos, 1, 6, P011, P111>(T);
+    tri<pos, 3, 6, P110, P111>(T);
+    tri<pos, 5, 6, P101, P111>(T);
+  }
+}
+
+inline hu_geometry::hu_geometry()
+{
+  static constexpr double tol = eps<double>;
+
+  double p0[3], p1[3], p2[3];
+  auto const get_p = [] (int l, double * p) {
+    p[0] = di<3>[l];
+    p[1] = dj<3>[l];
+    p[2] = dk<3>[l];
+  };
+
+  // Use the scalar triple product (dot(p x q, r)) to check if
+  // three points are coplanar.
+  double p0_x_p1[3];
+  for (int l0 = 0; l0 < 26; ++l0) {
+    get_p(l0, p0);
+    for (int l1 = 0; l1 < 26; ++l1) {
+      get_p(l1, p1);
+      p0_x_p1[0] = p0[1]*p1[2] - p0[2]*p1[1];
+      p0_x_p1[1] = p0[2]*p1[0] - p0[0]*p1[2];
+      p0_x_p1[2] = p0[0]*p1[1] - p0[1]*p1[0];
+      for (int l2 = 0; l2 < 26; ++l2) {
+        get_p(l2, p2);
+        int lin = linear_index(l0, l1, l2);
+        coplanar[lin] = fabs(
+          p0_x_p1[0]*p2[0] + p0_x_p1[1]*p2[1] + p0_x_p1[2]*p2[2]) < 1e1*tol;
+        geom_wkspcs[lin].init<3>(p0, p1, p2);
+        qr_wkspcs[lin].init(p0, p1, p2);
       }
     }
   }
 }
 
-template <cost_func F, class node, int lp_norm, int d1, int d2>
-void olim3d_hu<F, node, lp_norm, d1, d2>::init_crtp()
+template <int lp_norm, int d1, int d2>
+hu_candidates<lp_norm, d1, d2>::hu_candidates()
 {
-  // TODO: only allocate once
-  valid_d1 = new bool[26*26];
-  valid_d2 = new bool[26*26];
-  coplanar = new bool[26*26*26];
-  geom_wkspcs = new geom_wkspc<2>[26*26*26];
-  qr_wkspcs = new qr_wkspc<3, 2>[26*26*26];
-
   static constexpr double tol = eps<double>;
 
+  double p0[3], p1[3];
+  auto const get_p = [] (int l, double * p) {
+    p[0] = di<3>[l];
+    p[1] = dj<3>[l];
+    p[2] = dk<3>[l];
+  };
+
   auto const is_valid = [&] (int l0, int l1, int d) -> bool {
     get_p(l0, p0);
     get_p(l1, p1);
@@ -369,39 +499,43 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::init_crtp()
 
   for (int l0 = 0; l0 < 26; ++l0) {
     for (int l1 = 0; l1 < 26; ++l1) {
-      is_valid_d1(l0, l1) = is_valid(l0, l1, d1);
+      valid_d1[26*l0 + l1] = is_valid(l0, l1, d1);
+      valid_d2[26*l0 + l1] = is_valid(l0, l1, d2);
     }
   }
 
-  for (int l0 = 0; l0 < 26; ++l0) {
-    for (int l1 = 0; l1 < 26; ++l1) {
-      is_valid_d2(l0, l1) = is_valid(l0, l1, d2);
-    }
-  }
+  auto const & geometry = hu_geometry::get();
 
-  // Use the scalar triple product (dot(p x q, r)) to check if
-  // three points are coplanar.
-  double p0_x_p1[3];
   for (int l0 = 0; l0 < 26; ++l0) {
-    get_p(l0, p0);
+    tri_cands[l0] = 0;
     for (int l1 = 0; l1 < 26; ++l1) {
-      get_p(l1, p1);
-      p0_x_p1[0] = p0[1]*p1[2] - p0[2]*p1[1];
-      p0_x_p1[1] = p0[2]*p1[0] - p0[0]*p1[2];
-      p0_x_p1[2] = p0[0]*p1[1] - p0[1]*p1[0];
+      if (l1 != l0 && valid_d1[26*l0 + l1]) {
+        tri_cands[l0] |= uint32_t {1} << l1;
+      }
+      uint32_t & cands = tetra_cands[26*l0 + l1];
+      cands = 0;
       for (int l2 = 0; l2 < 26; ++l2) {
-        get_p(l2, p2);
-        is_coplanar(l0, l1, l2) = fabs(
-          p0_x_p1[0]*p2[0] + p0_x_p1[1]*p2[1] + p0_x_p1[2]*p2[2]) < 1e1*tol;
-        geom_wkspcs[linear_index(l0, l1, l2)].template init<3>(p0, p1, p2);
-        qr_wkspcs[linear_index(l0, l1, l2)].init(p0, p1, p2);
+        if (l2 != l0 && l2 != l1 &&
+            valid_d2[26*l0 + l2] && valid_d2[26*l1 + l2] &&
+            !geometry.coplanar[hu_geometry::linear_index(l0, l1, l2)]) {
+          cands |= uint32_t {1} << l2;
+        }
       }
     }
   }
 }
 
-template <cost_func F, class node, int lp_norm, int d1, int d2>
-void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
+template <cost_func F, class node, int lp_norm, int d1, int d2,
+          template <class> class queue, tetra_strategy S>
+void olim3d_hu<F, node, lp_norm, d1, d2, queue, S>::init_crtp()
+{
+  candidates = &hu_candidates<lp_norm, d1, d2>::get();
+  geometry = &hu_geometry::get();
+}
+
+template <cost_func F, class node, int lp_norm, int d1, int d2,
+          template <class> class queue, tetra_strategy S>
+void olim3d_hu<F, node, lp_norm, d1, d2, queue, S>::update_crtp(double & T)
 {
   using std::min;
 
@@ -425,12 +559,8 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
   ++this->_stats->count[0];
 #endif
 
-  if (n->is_factored()) {
-    auto fc = n->get_fac_center();
-    s_fac = fc->s;
-    p_fac[0] = fc->i - n->get_i();
-    p_fac[1] = fc->j - n->get_j();
-    p_fac[2] = fc->k - n->get_k();
+  if (this->fc) {
+    s_fac = this->fc->s;
   }
 
   // Create a cache for the minimizing lambdas to use for skipping
@@ -439,25 +569,27 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
   double arglam[26];
   std::fill(arglam, arglam + 26, -1);
 
-  // Find the minimal triangle update containing l0.
-  for (int l = 0; l < 26; ++l) {
-    if (l == l0 || !nb[l] || !is_valid_d1(l0, l)) {
-      continue;
-    }
+  // Find the minimal triangle update containing l0. The candidates
+  // are visited in increasing order, so ties go to the smallest l.
+  for (uint32_t cands = candidates->tri_cands[l0] & this->nb_mask;
+       cands; cands &= cands - 1) {
+    int l = ctz(cands);
 
     get_p(l, p1);
 
     // Do the triangle update.
-    auto const tmp = n->is_factored() ?
+    auto const tmp = this->fc ?
       updates::tri<F, 3>()(
         p0, p1, this->nb[l0]->get_value(), this->nb[l]->get_value(),
-        this->s_hat, this->s[l0], this->s[l], this->get_h(), p_fac, s_fac) :
+        this->s_hat, this->s[l0], this->s[l], this->get_h(), this->p_fac,
+        s_fac) :
       updates::tri<F, 3>()(
         p0, p1, this->nb[l0]->get_value(), this->nb[l]->get_value(),
         this->s_hat, this->s[l0], this->s[l], this->get_h());
 #if COLLECT_STATS
     ++this->_stats->count[1];
 #endif
+    this->tri_done(tmp.iters);
     Tnew = tmp.value;
     if (Tnew < T1) {
       T1 = Tnew;
@@ -477,15 +609,17 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
 
   // Do the tetrahedron updates such that p2 is sufficiently near p0
   // and p1.
-  for (int l2 = 0; l2 < 26; ++l2) {
-    if (l0 == l2 || l1 == l2 || !nb[l2] ||
-        !is_valid_d2(l0, l2) || !is_valid_d2(l1, l2) ||
-        is_coplanar(l0, l1, l2)) {
-      continue;
-    }
+  for (uint32_t cands = candidates->tetra_cands[26*l0 + l1] & this->nb_mask;
+       cands; cands &= cands - 1) {
+    int l2 = ctz(cands);
 
     get_p(l2, p2);
 
+    // Start from the minimizer of the best triangle update, (p0, p1),
+    // which is a face of this tetrahedron (this warm starts SQP for
+    // MP1 and the factored updates; see updates::tetra). For
+    // TRIS_FIRST, if the KKT conditions hold there, it's also the
+    // minimizer of the tetrahedron update, whose value is then T1.
     updates::info<2> info;
     info.lambda[0] = arglam[l1];
     info.lambda[1] = 0;
@@ -493,13 +627,20 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
       double u0 = this->nb[l0]->get_value(), u1 = this->nb[l1]->get_value(),
         u2 = this->nb[l2]->get_value(), s = this->s_hat, s0 = this->s[l0],
         s1 = this->s[l1], s2 = this->s[l2], h = this->get_h();
-      if (n->is_factored()) {
+      if (this->fc) {
         geom_fac_wkspc<2> g;
-        g.init<3>(p0, p1, p2, p_fac);
+        g.init<3>(p0, p1, p2, this->p_fac);
         F_fac_wkspc<F, 2> w;
         set_args<F>(w, g, u0, u1, u2, s, s0, s1, s2, h, s_fac);
         cost_functor_fac<F, 3, 2> func {w, g};
-        updates::tetra<F, 3>()(func, info);
+        if (S == tetra_strategy::TRIS_FIRST &&
+            updates::should_skip(func, info)) {
+          continue;
+        }
+        bool error;
+        int iters = updates::tetra<F, 3>(this->max_sqp_iters)(
+          func, info, &error);
+        this->sqp_done(iters, error);
         if (F == MP0) {
           eval_mp1_fix(func.w, s, s0, s1, s2, h, info.lambda, info.value);
         }
@@ -507,9 +648,16 @@ void olim3d_hu<F, node, lp_norm, d1, d2>::update_crtp(double & T)
         F_wkspc<F, 2> w;
         set_args<F>(w, u0, u1, u2, s, s0, s1, s2, h);
         int lin = linear_index(l0, l1, l2);
-        cost_functor<F, 3, 2> func {w, geom_wkspcs[lin]};
-        func.qr = &qr_wkspcs[lin];
-        updates::tetra<F, 3>()(func, info);
+        cost_functor<F, 3, 2> func {w, geometry->geom_wkspcs[lin]};
+        func.qr = &geometry->qr_wkspcs[lin];
+        if (S == tetra_strategy::TRIS_FIRST &&
+            updates::should_skip(func, info)) {
+          continue;
+        }
+        bool error;
+        int iters = updates::tetra<F, 3>(this->max_sqp_iters)(
+          func, info, &error);
+        this->sqp_done(iters, error);
         if (F == MP0 && info.inbounds()) {
           func.set_lambda(info.lambda);
           eval_mp1_fix(func.w, s, s0, s1, s2, h, info.lambda, info.value);
@@ -0,0 +1,141 @@
+#ifndef __PARALLEL_MARCHER_3D_HPP__
+#define __PARALLEL_MARCHER_3D_HPP__
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "common.hpp"
+#include "speed_funcs.hpp"
+#include "thread_pool.hpp"
+
+/**
+ * Solve the eikonal equation on a 3D grid in parallel by splitting it
+ * into blocks of block_size^3 nodes (fewer along the far edges of the
+ * grid), each of which is marched by its own copy of `olim' (any of
+ * the 3D marchers, e.g. olim6_rhr or olim26_mp1) with its own heap.
+ *
+ * Each block's marcher covers the nodes the block owns along with a
+ * layer of "ghost" nodes one node thick, which are owned by the
+ * neighboring blocks. This is enough for every update of a node the
+ * block owns to see all of the node's neighbors. A block never
+ * updates its ghost nodes itself (they're barrier nodes until their
+ * owners send their values). The blocks march in lockstep, in rounds:
+ *
+ * 1. The bound is raised by delta (or to the smallest trial value of
+ *    any block plus delta, if that's larger). Each block whose
+ *    smallest trial value is at most the bound marches until it
+ *    isn't (see marcher_3d::run_until). These blocks are marched
+ *    concurrently using a thread_pool.
+ *
+ * 2. Each block reads the values of its ghost nodes which their
+ *    owners accepted in step 1 and inserts the ones which went down
+ *    into its heap as trial nodes (see marcher_3d::add_trial_node),
+ *    which reactivates the block in the next round.
+ *
+ * A ghost value can arrive after the block has already accepted
+ * some of the ghost node's neighbors with larger values (the serial
+ * marcher would have accepted the ghost node first, and used it to
+ * update them). To fix this, each block's marcher reopens valid nodes
+ * whose values go down when one of their neighbors is accepted (see
+ * marcher_3d::allow_reopening), which is how Yang and Stern's
+ * parallel fast marching method handles this, too. Keeping the
+ * rounds short (delta is about the difference between the values of
+ * neighboring nodes) keeps the number of reopened nodes small.
+ *
+ * Since each block uses the same speeds and updates as a single
+ * marcher over the whole grid would, the result agrees with the
+ * serial marcher's up to rounding for RHR. MP0's and MP1's updates
+ * aren't always causal, so their results depend a little on the
+ * order in which nodes are accepted, which isn't the same (see
+ * test/parallel_marcher_3d.test.cpp).
+ *
+ * The blocks can also be solved by fast sweeping instead (see
+ * run_sweeps), which parallelizes better, since every block with
+ * new ghost values can work in every round: each block sweeps
+ * until it converges (see marcher_3d::run_sweeps), using the latest
+ * values of its ghost nodes that it's been sent, and then the blocks
+ * exchange ghost values, until none of them change.
+ *
+ * Factoring and the fractional add_boundary_node aren't supported.
+ */
+template <class olim>
+struct parallel_marcher_3d
+{
+  static constexpr int ndim = 3;
+
+  // If delta is zero, h times the average speed is used.
+  parallel_marcher_3d(int height, int width, int depth, double h = 1,
+                      std::function<double(double, double, double)> speed =
+                        static_cast<speed_func_3d>(default_speed_func),
+                      double x0 = 0.0, double y0 = 0.0, double z0 = 0.0,
+                      int block_size = 32, int num_threads = 0,
+                      double delta = 0.0);
+
+  void add_boundary_node(int i, int j, int k, double value = 0.0);
+  void run();
+  void run_sweeps();
+
+  double get_value(int i, int j, int k) const;
+  int get_height() const { return _height; }
+  int get_width() const { return _width; }
+  int get_depth() const { return _depth; }
+  int get_num_blocks() const { return static_cast<int>(_blocks.size()); }
+  int get_num_threads() const { return _pool.size(); }
+
+  // The number of rounds the last call to `run' or `run_sweeps'
+  // took, and the total number of times a block was marched (or
+  // swept) during them.
+  int get_num_rounds() const { return _num_rounds; }
+  int get_num_block_runs() const { return _num_block_runs; }
+
+EIKONAL_PRIVATE:
+  // Ghost nodes are stored using their global indices.
+  struct ghost_node {
+    int i, j, k, owner;
+    double value;
+  };
+
+  struct block {
+    // The block owns the nodes in [i0, i1) x [j0, j1) x [k0, k1). Its
+    // marcher covers [ei0, ei1) x [ej0, ej1) x [ek0, ek1), which is
+    // the same box grown by one node on each side (clipped to the
+    // grid).
+    int i0, i1, j0, j1, k0, k1;
+    int ei0, ei1, ej0, ej1, ek0, ek1;
+    std::unique_ptr<olim> marcher;
+    std::vector<ghost_node> ghosts;
+
+    // The ghosts (indices into `ghosts') whose values went down since
+    // the block last marched.
+    std::vector<int> pending;
+
+    // The smallest value in the block's heap or in `pending'. When
+    // sweeping, this is only used to tell whether the block has
+    // anything to do (i.e., whether it's finite).
+    double front {inf<double>};
+
+    bool ran {false}; // whether the block marched (or swept) this round
+  };
+
+  int block_index(int i, int j, int k) const {
+    return (i/_block_size) + _num_blocks[0]*(
+      (j/_block_size) + _num_blocks[1]*(k/_block_size));
+  }
+
+  void init_block(block & b, int bi, int bj, int bk);
+  void run_block(block & b, double bound);
+  void sweep_block(block & b);
+  void exchange(block & b, double bound);
+
+  int _height, _width, _depth, _block_size;
+  int _num_blocks[3];
+  double _delta;
+  std::vector<block> _blocks;
+  thread_pool _pool;
+  int _num_rounds {0}, _num_block_runs {0};
+};
+
+#include "parallel_marcher_3d.impl.hpp"
+
+#endif // __PARALLEL_MARCHER_3D_HPP__
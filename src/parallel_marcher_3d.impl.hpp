@@ -0,0 +1,293 @@
+#ifndef __PARALLEL_MARCHER_3D_IMPL_HPP__
+#define __PARALLEL_MARCHER_3D_IMPL_HPP__
+
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+
+template <class olim>
+parallel_marcher_3d<olim>::parallel_marcher_3d(
+  int height, int width, int depth, double h,
+  std::function<double(double, double, double)> speed,
+  double x0, double y0, double z0, int block_size, int num_threads,
+  double delta):
+  _height {height},
+  _width {width},
+  _depth {depth},
+  _block_size {block_size},
+  _delta {delta},
+  _pool {num_threads}
+{
+  assert(block_size > 0);
+  assert(delta >= 0);
+
+  _num_blocks[0] = (height + block_size - 1)/block_size;
+  _num_blocks[1] = (width + block_size - 1)/block_size;
+  _num_blocks[2] = (depth + block_size - 1)/block_size;
+  _blocks.resize(_num_blocks[0]*_num_blocks[1]*_num_blocks[2]);
+
+  // Evaluate the speed function for each block's marcher the same way
+  // marcher_3d does (so that the speeds are exactly the same as the
+  // serial marcher's). This is done serially, since we can't assume
+  // that `speed' is safe to call from several threads at once.
+  std::vector<std::vector<double>> s_caches(_blocks.size());
+  double s_sum = 0;
+  for (int bk = 0; bk < _num_blocks[2]; ++bk) {
+    for (int bj = 0; bj < _num_blocks[1]; ++bj) {
+      for (int bi = 0; bi < _num_blocks[0]; ++bi) {
+        int l = bi + _num_blocks[0]*(bj + _num_blocks[1]*bk);
+        block & b = _blocks[l];
+        init_block(b, bi, bj, bk);
+
+        int eh = b.ei1 - b.ei0, ew = b.ej1 - b.ej0;
+        auto & s_cache = s_caches[l];
+        s_cache.resize(eh*ew*(b.ek1 - b.ek0));
+        double x, z;
+        for (int k = b.ek0; k < b.ek1; ++k) {
+          z = h*k - z0;
+          for (int j = b.ej0; j < b.ej1; ++j) {
+            x = h*j - x0;
+            for (int i = b.ei0; i < b.ei1; ++i) {
+              int m = eh*(ew*(k - b.ek0) + j - b.ej0) + i - b.ei0;
+              s_cache[m] = speed(x, h*i - y0, z);
+              if (i >= b.i0 && i < b.i1 && j >= b.j0 && j < b.j1 &&
+                  k >= b.k0 && k < b.k1) {
+                s_sum += s_cache[m];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  if (_delta == 0) {
+    _delta = h*s_sum/(height*width*depth);
+  }
+
+  _pool.parallel_for(_blocks.size(), [&] (int l) {
+    block & b = _blocks[l];
+    b.marcher = std::make_unique<olim>(
+      b.ei1 - b.ei0, b.ej1 - b.ej0, b.ek1 - b.ek0, h, s_caches[l].data());
+    s_caches[l] = {};
+    b.marcher->allow_reopening();
+    for (auto const & g: b.ghosts) {
+      b.marcher->add_barrier_node(g.i - b.ei0, g.j - b.ej0, g.k - b.ek0);
+    }
+  });
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::init_block(block & b, int bi, int bj, int bk)
+{
+  b.i0 = _block_size*bi;
+  b.i1 = std::min(b.i0 + _block_size, _height);
+  b.j0 = _block_size*bj;
+  b.j1 = std::min(b.j0 + _block_size, _width);
+  b.k0 = _block_size*bk;
+  b.k1 = std::min(b.k0 + _block_size, _depth);
+
+  b.ei0 = std::max(b.i0 - 1, 0);
+  b.ei1 = std::min(b.i1 + 1, _height);
+  b.ej0 = std::max(b.j0 - 1, 0);
+  b.ej1 = std::min(b.j1 + 1, _width);
+  b.ek0 = std::max(b.k0 - 1, 0);
+  b.ek1 = std::min(b.k1 + 1, _depth);
+
+  for (int k = b.ek0; k < b.ek1; ++k) {
+    for (int j = b.ej0; j < b.ej1; ++j) {
+      for (int i = b.ei0; i < b.ei1; ++i) {
+        bool owned = b.i0 <= i && i < b.i1 && b.j0 <= j && j < b.j1 &&
+          b.k0 <= k && k < b.k1;
+        if (!owned) {
+          b.ghosts.push_back({i, j, k, block_index(i, j, k), inf<double>});
+        }
+      }
+    }
+  }
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::add_boundary_node(int i, int j, int k, double value)
+{
+  assert(0 <= i && i < _height);
+  assert(0 <= j && j < _width);
+  assert(0 <= k && k < _depth);
+
+  // Add the node to each block whose marcher covers it: i.e., its
+  // owner, and any block for which it's a ghost node.
+  int bi0 = std::max(i - 1, 0)/_block_size;
+  int bi1 = std::min(i + 1, _height - 1)/_block_size;
+  int bj0 = std::max(j - 1, 0)/_block_size;
+  int bj1 = std::min(j + 1, _width - 1)/_block_size;
+  int bk0 = std::max(k - 1, 0)/_block_size;
+  int bk1 = std::min(k + 1, _depth - 1)/_block_size;
+  for (int bk = bk0; bk <= bk1; ++bk) {
+    for (int bj = bj0; bj <= bj1; ++bj) {
+      for (int bi = bi0; bi <= bi1; ++bi) {
+        block & b = _blocks[bi + _num_blocks[0]*(bj + _num_blocks[1]*bk)];
+        assert(b.ei0 <= i && i < b.ei1);
+        assert(b.ej0 <= j && j < b.ej1);
+        assert(b.ek0 <= k && k < b.ek1);
+        b.marcher->add_boundary_node(i - b.ei0, j - b.ej0, k - b.ek0, value);
+        b.front = fmin(b.front, value);
+      }
+    }
+  }
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::run()
+{
+  _num_rounds = 0;
+  _num_block_runs = 0;
+
+  std::vector<int> active;
+  active.reserve(_blocks.size());
+
+  double bound = -inf<double>;
+  while (true) {
+    double front = inf<double>;
+    for (auto const & b: _blocks) {
+      front = fmin(front, b.front);
+    }
+    if (front == inf<double>) {
+      break;
+    }
+    bound = fmax(bound, front) + _delta;
+
+    active.clear();
+    for (int l = 0; l < static_cast<int>(_blocks.size()); ++l) {
+      if (_blocks[l].front <= bound) {
+        active.push_back(l);
+      }
+    }
+
+    ++_num_rounds;
+    _num_block_runs += static_cast<int>(active.size());
+
+    _pool.parallel_for(active.size(), [&] (int l) {
+      run_block(_blocks[active[l]], bound);
+    });
+
+    _pool.parallel_for(_blocks.size(), [&] (int l) {
+      exchange(_blocks[l], bound);
+    });
+
+    for (int l: active) {
+      _blocks[l].ran = false;
+    }
+  }
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::run_sweeps()
+{
+  _num_rounds = 0;
+  _num_block_runs = 0;
+
+  std::vector<int> active;
+  active.reserve(_blocks.size());
+
+  while (true) {
+    active.clear();
+    for (int l = 0; l < static_cast<int>(_blocks.size()); ++l) {
+      if (_blocks[l].front < inf<double>) {
+        active.push_back(l);
+      }
+    }
+    if (active.empty()) {
+      break;
+    }
+
+    ++_num_rounds;
+    _num_block_runs += static_cast<int>(active.size());
+
+    _pool.parallel_for(active.size(), [&] (int l) {
+      sweep_block(_blocks[active[l]]);
+    });
+
+    _pool.parallel_for(_blocks.size(), [&] (int l) {
+      exchange(_blocks[l], inf<double>);
+    });
+
+    for (int l: active) {
+      _blocks[l].ran = false;
+    }
+  }
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::run_block(block & b, double bound)
+{
+  olim & m = *b.marcher;
+  for (int l: b.pending) {
+    auto const & g = b.ghosts[l];
+    m.add_trial_node(g.i - b.ei0, g.j - b.ej0, g.k - b.ek0, g.value);
+  }
+  b.pending.clear();
+  b.front = m.run_until(bound);
+  b.ran = true;
+}
+
+template <class olim>
+void
+parallel_marcher_3d<olim>::sweep_block(block & b)
+{
+  olim & m = *b.marcher;
+  for (int l: b.pending) {
+    auto const & g = b.ghosts[l];
+    int i = g.i - b.ei0, j = g.j - b.ej0, k = g.k - b.ek0;
+    // (A ghost node which is also a boundary node isn't a barrier.)
+    if (g.value < m.get_value(i, j, k)) {
+      m.set_barrier_value(i, j, k, g.value);
+    }
+  }
+  b.pending.clear();
+  m.run_sweeps();
+  b.front = inf<double>;
+  b.ran = true;
+}
+
+/**
+ * Read the values of b's ghost nodes which their owners accepted this
+ * round (i.e., which are at most `bound'), and queue up the ones that
+ * went down. When sweeping, `bound' is inf.
+ */
+template <class olim>
+void
+parallel_marcher_3d<olim>::exchange(block & b, double bound)
+{
+  for (int l = 0; l < static_cast<int>(b.ghosts.size()); ++l) {
+    auto & g = b.ghosts[l];
+    block const & owner = _blocks[g.owner];
+    if (!owner.ran) continue;
+
+    double value = owner.marcher->get_value(
+      g.i - owner.ei0, g.j - owner.ej0, g.k - owner.ek0);
+    if (value <= bound && value < g.value) {
+      g.value = value;
+      b.pending.push_back(l);
+      b.front = fmin(b.front, value);
+    }
+  }
+}
+
+template <class olim>
+double
+parallel_marcher_3d<olim>::get_value(int i, int j, int k) const
+{
+  assert(0 <= i && i < _height);
+  assert(0 <= j && j < _width);
+  assert(0 <= k && k < _depth);
+  block const & b = _blocks[block_index(i, j, k)];
+  return b.marcher->get_value(i - b.ei0, j - b.ej0, k - b.ek0);
+}
+
+#endif // __PARALLEL_MARCHER_3D_IMPL_HPP__
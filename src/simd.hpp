@@ -0,0 +1,163 @@
+#ifndef __SIMD_HPP__
+#define __SIMD_HPP__
+
+#include <math.h>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#  include <immintrin.h>
+#endif
+
+/**
+ * Minimal wrappers around the packed double precision instructions
+ * used by the batched update kernels (see updates.tri_batch.hpp and
+ * updates.tetra_batch.hpp). A
+ * kernel is written once against the interface below, and `native'
+ * picks the widest instruction set the translation unit was compiled
+ * for (AVX, SSE2, or plain scalar code as a fallback). To get the AVX
+ * version, build with -DNATIVE_ARCH=ON (which passes -march=native to
+ * the compiler).
+ *
+ * There's deliberately no AVX-512 version: the batches are short (for
+ * olim18 and olim26, an update solves 1.5--2.2 triangle updates on
+ * average and never more than 6, since most of them are skipped after
+ * the tetrahedron updates), so the extra lanes go to waste, and the
+ * 512-bit version was measurably slower than the 256-bit one.
+ *
+ * Each wrapper provides:
+ *
+ * - `reg' and `mask': a register of `width' doubles and the result of
+ *   comparing two of them,
+ * - load, store, set1, add, sub, mul, div, neg, sqrt, abs, and min
+ *   (min(a, b) == b < a ? b : a, lane-wise, like std::min),
+ * - lt, gt, le, ge, and eq, which compare lane-wise, and lor and
+ *   land, which combine two masks,
+ * - blend(m, a, b), which selects b where m is set and a elsewhere,
+ * - hmin, which reduces a register to its smallest lane.
+ *
+ * All of these are exact IEEE operations, so a kernel gives the same
+ * answer whichever wrapper it's instantiated with (as long as the
+ * compiler isn't allowed to contract multiplies and adds).
+ */
+
+namespace simd {
+
+struct scalar {
+  using reg = double;
+  using mask = bool;
+  static constexpr int width = 1;
+
+  static inline reg load(double const * p) { return *p; }
+  static inline void store(double * p, reg a) { *p = a; }
+  static inline reg set1(double x) { return x; }
+  static inline reg add(reg a, reg b) { return a + b; }
+  static inline reg sub(reg a, reg b) { return a - b; }
+  static inline reg mul(reg a, reg b) { return a*b; }
+  static inline reg div(reg a, reg b) { return a/b; }
+  static inline reg neg(reg a) { return -a; }
+  static inline reg sqrt(reg a) { return ::sqrt(a); }
+  static inline reg abs(reg a) { return fabs(a); }
+  static inline reg min(reg a, reg b) { return b < a ? b : a; }
+  static inline mask lt(reg a, reg b) { return a < b; }
+  static inline mask gt(reg a, reg b) { return a > b; }
+  static inline mask le(reg a, reg b) { return a <= b; }
+  static inline mask ge(reg a, reg b) { return a >= b; }
+  static inline mask eq(reg a, reg b) { return a == b; }
+  static inline mask lor(mask a, mask b) { return a || b; }
+  static inline mask land(mask a, mask b) { return a && b; }
+  static inline reg blend(mask m, reg a, reg b) { return m ? b : a; }
+  static inline double hmin(reg a) { return a; }
+};
+
+#ifdef __SSE2__
+struct sse2 {
+  using reg = __m128d;
+  using mask = __m128d;
+  static constexpr int width = 2;
+
+  static inline reg load(double const * p) { return _mm_loadu_pd(p); }
+  static inline void store(double * p, reg a) { _mm_storeu_pd(p, a); }
+  static inline reg set1(double x) { return _mm_set1_pd(x); }
+  static inline reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+  static inline reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+  static inline reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+  static inline reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+  static inline reg neg(reg a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+  static inline reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+  static inline reg abs(reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+  static inline reg min(reg a, reg b) { return _mm_min_pd(b, a); }
+  static inline mask lt(reg a, reg b) { return _mm_cmplt_pd(a, b); }
+  static inline mask gt(reg a, reg b) { return _mm_cmpgt_pd(a, b); }
+  static inline mask le(reg a, reg b) { return _mm_cmple_pd(a, b); }
+  static inline mask ge(reg a, reg b) { return _mm_cmpge_pd(a, b); }
+  static inline mask eq(reg a, reg b) { return _mm_cmpeq_pd(a, b); }
+  static inline mask lor(mask a, mask b) { return _mm_or_pd(a, b); }
+  static inline mask land(mask a, mask b) { return _mm_and_pd(a, b); }
+  static inline reg blend(mask m, reg a, reg b) {
+    return _mm_or_pd(_mm_and_pd(m, b), _mm_andnot_pd(m, a));
+  }
+  static inline double hmin(reg a) {
+    return _mm_cvtsd_f64(_mm_min_sd(a, _mm_unpackhi_pd(a, a)));
+  }
+};
+#endif
+
+#ifdef __AVX__
+struct avx {
+  using reg = __m256d;
+  using mask = __m256d;
+  static constexpr int width = 4;
+
+  static inline reg load(double const * p) { return _mm256_loadu_pd(p); }
+  static inline void store(double * p, reg a) { _mm256_storeu_pd(p, a); }
+  static inline reg set1(double x) { return _mm256_set1_pd(x); }
+  static inline reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+  static inline reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+  static inline reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+  static inline reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+  static inline reg neg(reg a) {
+    return _mm256_xor_pd(a, _mm256_set1_pd(-0.0));
+  }
+  static inline reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+  static inline reg abs(reg a) {
+    return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a);
+  }
+  static inline reg min(reg a, reg b) { return _mm256_min_pd(b, a); }
+  static inline mask lt(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+  }
+  static inline mask gt(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+  }
+  static inline mask le(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_LE_OQ);
+  }
+  static inline mask ge(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_GE_OQ);
+  }
+  static inline mask eq(reg a, reg b) {
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+  }
+  static inline mask lor(mask a, mask b) { return _mm256_or_pd(a, b); }
+  static inline mask land(mask a, mask b) { return _mm256_and_pd(a, b); }
+  static inline reg blend(mask m, reg a, reg b) {
+    return _mm256_blendv_pd(a, b, m);
+  }
+  static inline double hmin(reg a) {
+    return sse2::hmin(
+      _mm_min_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1)));
+  }
+};
+#endif
+
+
+#if defined(__AVX__)
+using native = avx;
+#elif defined(__SSE2__)
+using native = sse2;
+#else
+using native = scalar;
+#endif
+
+}
+
+#endif // __SIMD_HPP__
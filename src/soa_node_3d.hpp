@@ -0,0 +1,55 @@
+#ifndef __SOA_NODE_3D_HPP__
+#define __SOA_NODE_3D_HPP__
+
+#include <src/config.hpp>
+
+#include "node_3d.hpp"
+
+/**
+ * A node type for marcher_3d which only holds the node's value. When
+ * a marcher is instantiated with this node type, its node array is
+ * just an array of values, and everything else that node_3d stores is
+ * kept elsewhere:
+ *
+ * - the states are kept in a separate array (one byte per node),
+ * - the factoring centers are kept in a separate array of pointers
+ *   which is only allocated once `set_node_fac_center' is called,
+ * - the node's indices aren't stored at all: they're recovered from
+ *   the node's offset into the node array,
+ * - there's no heap position, so the queue needs to keep track of
+ *   node positions itself (i.e., use `heap4' or `heap8' from
+ *   dary_heap.hpp).
+ *
+ * This brings the memory used per node down from sizeof(node_3d) ==
+ * 40 bytes to 8 + 1 + 4 bytes (value, state, and the d-ary heap's
+ * position array), plus the speed function cache. With T = float
+ * (soa_float_node_3d), the values and the speed function cache are
+ * stored in single precision.
+ */
+template <class T>
+struct basic_soa_node_3d {
+  using fac_center = node_3d::fac_center;
+  using float_type = T;
+
+  static constexpr bool is_soa = true;
+  static constexpr bool has_fac_index = false;
+
+  basic_soa_node_3d() {}
+  basic_soa_node_3d(double value): _value {static_cast<T>(value)} {}
+
+  inline double get_value() const { return _value; }
+  inline void set_value(double value) { _value = static_cast<T>(value); }
+
+EIKONAL_PRIVATE:
+  T _value {std::numeric_limits<T>::infinity()};
+};
+
+using soa_node_3d = basic_soa_node_3d<double>;
+using soa_float_node_3d = basic_soa_node_3d<float>;
+
+static_assert(sizeof(soa_node_3d) == sizeof(double),
+              "soa_node_3d should only hold the node's value");
+static_assert(sizeof(soa_float_node_3d) == sizeof(float),
+              "soa_float_node_3d should only hold the node's value");
+
+#endif // __SOA_NODE_3D_HPP__
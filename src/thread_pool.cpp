@@ -0,0 +1,90 @@
+#include "thread_pool.hpp"
+
+#include <assert.h>
+
+#include <algorithm>
+
+thread_pool::thread_pool(int num_threads):
+  _num_threads {num_threads > 0 ? num_threads :
+    std::max(1, static_cast<int>(std::thread::hardware_concurrency()))}
+{
+  _workers.reserve(_num_threads - 1);
+  for (int t = 1; t < _num_threads; ++t) {
+    _workers.emplace_back([this] () { work(); });
+  }
+}
+
+thread_pool::~thread_pool()
+{
+  {
+    std::lock_guard<std::mutex> lock {_mutex};
+    _stop = true;
+  }
+  _start.notify_all();
+  for (auto & worker: _workers) {
+    worker.join();
+  }
+}
+
+void thread_pool::parallel_for(int n, std::function<void(int)> const & f)
+{
+  assert(n >= 0);
+
+  // Don't bother waking up the workers if there's only one thing to
+  // do (or nobody to wake up).
+  if (_workers.empty() || n <= 1) {
+    for (int i = 0; i < n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock {_mutex};
+    _f = &f;
+    _n = n;
+    _next = 0;
+    _num_running = static_cast<int>(_workers.size());
+    ++_generation;
+  }
+  _start.notify_all();
+
+  run_loop();
+
+  // Every worker has to finish this loop before the next one can be
+  // started, since they check _generation to see if there's work.
+  std::unique_lock<std::mutex> lock {_mutex};
+  _done.wait(lock, [this] () { return _num_running == 0; });
+  _f = nullptr;
+}
+
+void thread_pool::run_loop()
+{
+  for (int i = _next++; i < _n; i = _next++) {
+    (*_f)(i);
+  }
+}
+
+void thread_pool::work()
+{
+  int generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock {_mutex};
+      _start.wait(lock, [&] () { return _stop || _generation != generation; });
+      if (_stop) {
+        return;
+      }
+      generation = _generation;
+    }
+
+    run_loop();
+
+    {
+      std::lock_guard<std::mutex> lock {_mutex};
+      if (--_num_running == 0) {
+        _done.notify_one();
+      }
+    }
+  }
+}
@@ -0,0 +1,59 @@
+#ifndef __THREAD_POOL_HPP__
+#define __THREAD_POOL_HPP__
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+
+/**
+ * A fixed set of worker threads for running parallel loops. The
+ * workers are started when the pool is constructed and wait on a
+ * condition variable in between loops, so that a loop whose body is
+ * short doesn't pay for starting and joining threads.
+ *
+ * If `num_threads' is zero, the pool uses one thread per hardware
+ * thread (as reported by std::thread::hardware_concurrency). The
+ * thread calling `parallel_for' counts as one of the pool's threads.
+ */
+struct thread_pool
+{
+  explicit thread_pool(int num_threads = 0);
+  ~thread_pool();
+
+  thread_pool(thread_pool const &) = delete;
+  thread_pool & operator=(thread_pool const &) = delete;
+
+  int size() const { return _num_threads; }
+
+  // Call f(i) for i = 0, ..., n - 1 and return once every call has
+  // returned. The calls are handed out to the pool's threads one at a
+  // time, in order, so f should be safe to call concurrently for
+  // different values of i.
+  void parallel_for(int n, std::function<void(int)> const & f);
+
+EIKONAL_PRIVATE:
+  void work();
+  void run_loop();
+
+  int _num_threads;
+  std::vector<std::thread> _workers;
+
+  // The loop currently being run. These are only written by
+  // parallel_for while none of the workers are in run_loop.
+  std::function<void(int)> const * _f {nullptr};
+  int _n {0};
+  std::atomic<int> _next {0};
+
+  std::mutex _mutex;
+  std::condition_variable _start, _done;
+  int _generation {0}; // the number of loops started so far
+  int _num_running {0}; // the number of workers still in the current loop
+  bool _stop {false};
+};
+
+#endif // __THREAD_POOL_HPP__
@@ -12,6 +12,9 @@ struct info<1>
   double value {inf<double>};
   double lambda[1] = {0.5};
   double tol {1e1*eps<double>};
+  // The number of root finding iterations it took to find lambda
+  // (zero for the updates which are solved directly).
+  int iters {0};
   inline bool inbounds() const {
     return 0 <= lambda[0] && lambda[0] <= 1;
   }
@@ -48,6 +51,16 @@ struct stats
   int num_visits {0};
   int count[n];
 
+  // The total number of SQP iterations done by the tetrahedron
+  // updates, and the number of them which hit the iteration cap (see
+  // updates::tetra).
+  int sqp_iters {0};
+  int sqp_failures {0};
+
+  // The total number of root finding iterations done by the triangle
+  // updates (see info<1>::iters).
+  int tri_iters {0};
+
   stats() { for (int d = 0; d < n; ++d) count[d] = 0; }
 };
 #endif
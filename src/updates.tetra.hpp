@@ -17,16 +17,34 @@ namespace updates {
 // TODO: can probably also remove the cost_functor thing
 // entirely... Not sure about whether this is worth it or not
 
+/**
+ * MP1's tetrahedron updates and the factored tetrahedron updates are
+ * solved with SQP (see sqp_bary). SQP starts from `info.lambda' if it
+ * is in bounds (e.g., the minimizer of the best triangle update on one
+ * of the tetrahedron's faces), and from the centroid otherwise. If
+ * `max_iters' is positive, at most that many iterations are done: if
+ * SQP hasn't converged by then, `*error' is set, and `info' holds the
+ * last iterate and the value there (which is still an upper bound for
+ * the update). The return value is the number of SQP iterations done
+ * (zero if the update was solved directly).
+ */
 template <cost_func F, int n>
 struct tetra {
-  void operator()(cost_functor<F, n, 2> & func, info<2> & info) const;
-  void operator()(cost_functor_fac<F, n, 2> & func, info<2> & info) const;
+  tetra(int max_iters = 0): max_iters {max_iters} {}
+  int operator()(cost_functor<F, n, 2> & func, info<2> & info,
+                 bool * error = nullptr) const;
+  int operator()(cost_functor_fac<F, n, 2> & func, info<2> & info,
+                 bool * error = nullptr) const;
+  int max_iters;
 };
 
 template <cost_func F, int n, int p0, int p1, int p2>
 struct tetra_bv
 {
-  void operator()(cost_functor_bv<F, n, p0, p1, p2> & func, info<2> & info) const;
+  tetra_bv(int max_iters = 0): max_iters {max_iters} {}
+  int operator()(cost_functor_bv<F, n, p0, p1, p2> & func, info<2> & info,
+                 bool * error = nullptr) const;
+  int max_iters;
 
   // TODO: we aren't actually using this overload yet...
   // template <int n, int p0, int p1, int p2>
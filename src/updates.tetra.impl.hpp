@@ -16,11 +16,17 @@
 
 namespace updates {
 
-// TODO: this should (probably) eventually become an olim3d_hu member
-// function, since that's the only class that uses it...
-// TODO: simplify interface using template template parameter...?
-template <cost_func F, int n>
-inline bool should_skip(cost_functor<F, n, 2> & func, info<2> const & info) {
+/**
+ * Check whether `info.lambda', a point on the boundary of the unit
+ * simplex, satisfies the KKT conditions for `func' (i.e., whether all
+ * of the Lagrange multipliers of its active constraints are
+ * nonnegative). If it does, it's the minimizer of `func' over the
+ * simplex, and there's no need to do the tetrahedron update. This
+ * works for any cost functor (cost_functor, cost_functor_bv, or
+ * cost_functor_fac).
+ */
+template <class cost_functor_t>
+inline bool should_skip(cost_functor_t & func, info<2> const & info) {
   // TODO: instead, `assert(info.on_boundary())' here, since if
   // in_interior() is true, then this is false... so a bit of a waste!
   if (info.in_interior()) {
@@ -42,54 +48,68 @@ inline bool should_skip(cost_functor<F, n, 2> & func, info<2> const & info) {
   return true;
 }
 
+template <cost_func F, int n>
+inline bool should_skip(cost_functor<F, n, 2> & func, info<2> const & info) {
+  return should_skip<cost_functor<F, n, 2>>(func, info);
+}
+
 }
 
 template <cost_func F, int n>
-void
+int
 updates::tetra<F, n>::operator()(
-  cost_functor<F, n, 2> & func, info<2> & info) const
+  cost_functor<F, n, 2> & func, info<2> & info, bool * error) const
 {
   if (F == MP1) {
-    bool error;
-    sqp_bary<decltype(func), n, 2>()(
+    return sqp_bary<decltype(func), n, 2>()(
       func,
-      nullptr, // TODO: warm start
+      info.inbounds() ? info.lambda : nullptr,
       info.lambda,
       &info.value,
-      &error);
-    assert(!error);
+      error,
+      eps<double>,
+      max_iters);
   } else {
+    if (error) *error = false;
     direct_solve<F, n>(func.w, func.qr, info.lambda, info.value);
+    return 0;
   }
 }
 
 template <cost_func F, int n>
-void
+int
 updates::tetra<F, n>::operator()(
-  cost_functor_fac<F, n, 2> & func, info<2> & info) const
+  cost_functor_fac<F, n, 2> & func, info<2> & info, bool * error) const
 {
-  bool error;
-  sqp_bary<decltype(func), n, 2, line_search::BACKTRACK>()(
-    func, nullptr, info.lambda, &info.value, &error);
-  assert(!error);
+  return sqp_bary<decltype(func), n, 2, line_search::BACKTRACK>()(
+    func,
+    info.inbounds() ? info.lambda : nullptr,
+    info.lambda,
+    &info.value,
+    error,
+    eps<double>,
+    max_iters);
 }
 
 template <cost_func F, int n, int p0, int p1, int p2>
-void
+int
 updates::tetra_bv<F, n, p0, p1, p2>::operator()(
-  cost_functor_bv<F, n, p0, p1, p2> & func, info<2> & info) const
+  cost_functor_bv<F, n, p0, p1, p2> & func, info<2> & info,
+  bool * error) const
 {
   if (F == MP1) {
-    bool error;
-    sqp_bary<decltype(func), n, 2>()(
+    return sqp_bary<decltype(func), n, 2>()(
       func,
       info.inbounds() ? info.lambda : nullptr,
       info.lambda,
       &info.value,
-      &error);
-    assert(!error);
+      error,
+      eps<double>,
+      max_iters);
   } else {
+    if (error) *error = false;
     direct_solve<F, n, p0, p1, p2>(func.w, info.lambda, info.value);
+    return 0;
   }
 }
 
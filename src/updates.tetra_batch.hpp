@@ -0,0 +1,79 @@
+#ifndef __UPDATES_TETRA_BATCH_HPP__
+#define __UPDATES_TETRA_BATCH_HPP__
+
+#include "common.hpp"
+#include "cost_funcs.hpp"
+#include "simd.hpp"
+#include "updates.common.hpp"
+
+namespace updates {
+
+/**
+ * A batch of tetrahedron updates with bit vector offsets (see
+ * tetra_bv) which all share the same update node. The marcher pushes
+ * (u0, u1, u2, s0, s1, s2) for each admissible tetrahedron, along with
+ * its precomputed geometry (the entries of R and the numerator of the
+ * exact solution from bitops.hpp), and then solves all of them at once
+ * with `solve'. After that, `get_info(k)' returns what tetra_bv would
+ * have returned for the kth tetrahedron that was pushed, so that the
+ * caller can decide which triangle updates to skip.
+ *
+ * For MP0 and RHR, the tetrahedron update is solved directly (see
+ * direct_solve in cost_funcs.hpp), which `solve' does several lanes
+ * at a time (see simd.hpp), including evaluating MP1 at MP0's
+ * minimizer (eval_mp1_fix) for MP0. MP1's tetrahedron updates are
+ * solved using SQP, and can't be batched this way.
+ */
+template <cost_func F, int n, int capacity>
+struct tetra_bv_batch
+{
+  inline void reset(double s, double h) {
+    _size = 0;
+    _s = s;
+    _h = h;
+  }
+
+  template <int p0, int p1, int p2>
+  inline void push(double u0, double u1, double u2,
+                   double s0, double s1, double s2);
+
+  void solve();
+
+  inline int size() const { return _size; }
+
+  inline info<2> get_info(int k) const {
+    assert(0 <= k && k < _size);
+    info<2> info;
+    info.value = _value[k];
+    info.lambda[0] = _lam0[k];
+    info.lambda[1] = _lam1[k];
+    return info;
+  }
+
+EIKONAL_PRIVATE:
+  template <class V>
+  inline void solve(int k);
+
+  int _size {0};
+  double _s, _h;
+
+  // The values and speeds at the vertices of each tetrahedron.
+  double _u0[capacity], _du0[capacity], _du1[capacity], _sh[capacity];
+  double _s0[capacity], _ds1[capacity], _ds2[capacity];
+
+  // The geometry of each tetrahedron (as in direct_solve and
+  // set_lambda in cost_funcs.hpp).
+  double _r11[capacity], _r12[capacity], _r22[capacity];
+  double _numer[capacity], _Qt_p0_0[capacity], _Qt_p0_1[capacity];
+  double _p0_dot_p0[capacity], _p1_dot_p0[capacity], _p2_dot_p0[capacity];
+  double _dPt_dP_0[capacity], _dPt_dP_1[capacity], _dPt_dP_2[capacity];
+
+  // The solution of each tetrahedron update.
+  double _value[capacity], _lam0[capacity], _lam1[capacity];
+};
+
+}
+
+#include "updates.tetra_batch.impl.hpp"
+
+#endif // __UPDATES_TETRA_BATCH_HPP__
@@ -0,0 +1,147 @@
+#ifndef __UPDATES_TETRA_BATCH_IMPL_HPP__
+#define __UPDATES_TETRA_BATCH_IMPL_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+
+#include "bitops.hpp"
+
+template <cost_func F, int n, int capacity>
+template <int p0, int p1, int p2>
+void
+updates::tetra_bv_batch<F, n, capacity>::push(
+  double u0, double u1, double u2, double s0, double s1, double s2)
+{
+  using namespace bitops;
+
+  static_assert(F != MP1, "MP1's tetrahedron updates are solved with SQP");
+
+  check_args(u0, u1, u2, _s, s0, s1, s2, _h);
+
+  assert(_size < capacity);
+
+  int const k = _size++;
+
+  _u0[k] = u0;
+  _du0[k] = u1 - u0;
+  _du1[k] = u2 - u0;
+  _sh[k] = (F == RHR ? _s : (_s + (s0 + s1 + s2)/3)/2)*_h;
+  _s0[k] = s0;
+  _ds1[k] = s1 - s0;
+  _ds2[k] = s2 - s0;
+
+  constexpr dim<3> d {};
+  _r11[k] = R<p0, p1, p2, 0>(d);
+  _r12[k] = R<p0, p1, p2, 1>(d);
+  _r22[k] = R<p0, p1, p2, 2>(d);
+  _numer[k] = exact_soln_numer<p0, p1, p2>(d);
+  _Qt_p0_0[k] = Qt_dot_p0<p0, p1, p2, 0>(d);
+  _Qt_p0_1[k] = Qt_dot_p0<p0, p1, p2, 1>(d);
+  _p0_dot_p0[k] = p_dot_q<p0, p0>(d);
+  _p1_dot_p0[k] = p_dot_q<p1, p0>(d);
+  _p2_dot_p0[k] = p_dot_q<p2, p0>(d);
+  _dPt_dP_0[k] = dPt_dP<p0, p1, p2, 0>(d);
+  _dPt_dP_1[k] = dPt_dP<p0, p1, p2, 1>(d);
+  _dPt_dP_2[k] = dPt_dP<p0, p1, p2, 2>(d);
+}
+
+template <cost_func F, int n, int capacity>
+void
+updates::tetra_bv_batch<F, n, capacity>::solve()
+{
+  using V = simd::native;
+
+  int k = 0;
+  for (; k + V::width <= _size; k += V::width) {
+    solve<V>(k);
+  }
+  for (; k < _size; ++k) {
+    solve<simd::scalar>(k);
+  }
+}
+
+/**
+ * Solve lanes k through k + V::width - 1 of the batch. This follows
+ * direct_solve<F, n, p0, p1, p2> (and, for MP0, set_lambda and
+ * eval_mp1_fix) operation for operation, so the results are the same
+ * as tetra_bv's.
+ */
+template <cost_func F, int n, int capacity>
+template <class V>
+void
+updates::tetra_bv_batch<F, n, capacity>::solve(int k)
+{
+  using reg = typename V::reg;
+  using mask = typename V::mask;
+
+  reg const zero = V::set1(0), one = V::set1(1), two = V::set1(2);
+  reg const inf_ = V::set1(inf<double>);
+
+  reg const u0 = V::load(&_u0[k]);
+  reg const du0 = V::load(&_du0[k]), du1 = V::load(&_du1[k]);
+  reg const sh = V::load(&_sh[k]);
+  reg const r11 = V::load(&_r11[k]), r12 = V::load(&_r12[k]);
+  reg const r22 = V::load(&_r22[k]);
+
+  // Compute A = inv(R')*du/sh.
+  reg A0 = V::div(du0, sh), A1 = V::div(du1, sh);
+  A1 = V::sub(A1, V::div(V::mul(r12, A0), r11));
+  A1 = V::div(A1, r22);
+  A0 = V::div(A0, r11);
+
+  // If A'*A >= 1, F is unbounded below, and lopt and lambda are NaN
+  // here (they're replaced by inf below).
+  reg const A_dot_A = V::add(V::mul(A0, A0), V::mul(A1, A1));
+  mask const bounded = V::lt(A_dot_A, one);
+  reg const lopt =
+    V::sqrt(V::div(V::load(&_numer[k]), V::sub(one, A_dot_A)));
+
+  reg lam0 = V::add(V::load(&_Qt_p0_0[k]), V::mul(lopt, A0));
+  reg lam1 = V::add(V::load(&_Qt_p0_1[k]), V::mul(lopt, A1));
+  lam1 = V::div(lam1, V::neg(r22));
+  lam0 = V::add(lam0, V::mul(r12, lam1));
+  lam0 = V::div(lam0, V::neg(r11));
+
+  mask const inbounds = V::land(
+    V::land(V::ge(lam0, zero), V::ge(lam1, zero)),
+    V::le(V::add(lam0, lam1), one));
+
+  reg const u_lam = V::add(V::add(u0, V::mul(du0, lam0)), V::mul(du1, lam1));
+
+  reg value;
+  if (F == MP0) {
+    reg const p0_dot_p0 = V::load(&_p0_dot_p0[k]);
+    reg const p1_dot_p0 = V::load(&_p1_dot_p0[k]);
+    reg const p2_dot_p0 = V::load(&_p2_dot_p0[k]);
+    reg const dPt_dP_0 = V::load(&_dPt_dP_0[k]);
+    reg const dPt_dP_1 = V::load(&_dPt_dP_1[k]);
+    reg const dPt_dP_2 = V::load(&_dPt_dP_2[k]);
+    reg const dPt_p0_1 = V::sub(p1_dot_p0, p0_dot_p0);
+    reg const dPt_p0_2 = V::sub(p2_dot_p0, p0_dot_p0);
+
+    reg const nu0 = V::sub(V::add(V::add(V::mul(dPt_dP_0, lam0),
+                                         V::mul(dPt_dP_1, lam1)),
+                                  p1_dot_p0), p0_dot_p0);
+    reg const nu1 = V::sub(V::add(V::add(V::mul(dPt_dP_1, lam0),
+                                         V::mul(dPt_dP_2, lam1)),
+                                  p2_dot_p0), p0_dot_p0);
+    reg const l_lam = V::sqrt(
+      V::add(V::add(p0_dot_p0, V::mul(V::add(dPt_p0_1, nu0), lam0)),
+             V::mul(V::add(dPt_p0_2, nu1), lam1)));
+
+    reg const s = V::set1(_s), h = V::set1(_h);
+    reg const s_lam = V::add(
+      V::add(V::add(s, V::load(&_s0[k])), V::mul(V::load(&_ds1[k]), lam0)),
+      V::mul(V::load(&_ds2[k]), lam1));
+    value = V::add(u_lam, V::div(V::mul(V::mul(h, s_lam), l_lam), two));
+  } else {
+    value = V::add(u_lam, V::mul(sh, lopt));
+  }
+
+  V::store(&_value[k], V::blend(inbounds, inf_, value));
+  V::store(&_lam0[k], V::blend(bounded, inf_, lam0));
+  V::store(&_lam1[k], V::blend(bounded, inf_, lam1));
+}
+
+#endif // __UPDATES_TETRA_BATCH_IMPL_HPP__
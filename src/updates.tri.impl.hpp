@@ -102,21 +102,28 @@ updates::tri<MP0, n>::operator()(
   double dp[n];
   sub<n>(p1, p0, dp);
 
-  double nu[n], nufac[n];
+  double nu[n], nufac[n], dp_dot_dp = dot<n>(dp, dp);
 
-  auto const grad = [&] (double lam) {
+  // Returns dF/dlam and sets d2F to d2F/dlam2 (the derivative of
+  // dot(dp, p/|p|) with respect to lam is (|dp|^2 - dot(dp, p/|p|)^2)/|p|).
+  auto const grad = [&] (double lam, double & d2F) {
     axpy<n>(lam, dp, p0, nu);
     sub<n>(nu, p_fac, nufac);
-    scal_inplace<n>(1./norm2<n>(nu), nu);
-    scal_inplace<n>(1./norm2<n>(nufac), nufac);
-    return dtau + shfac*dot<n>(dp, nufac) + sh*dot<n>(dp, nu);
+    double const l = norm2<n>(nu), lfac = norm2<n>(nufac);
+    double const dp_dot_nu = dot<n>(dp, nu)/l;
+    double const dp_dot_nufac = dot<n>(dp, nufac)/lfac;
+    d2F = shfac*(dp_dot_dp - dp_dot_nufac*dp_dot_nufac)/lfac +
+      sh*(dp_dot_dp - dp_dot_nu*dp_dot_nu)/l;
+    return dtau + shfac*dp_dot_nufac + sh*dp_dot_nu;
   };
 
+  info<1> info;
+
   double arglam;
   hybrid_status status;
-  std::tie(arglam, status) = hybrid(grad, 0., 1.);
+  std::tie(arglam, status) = hybrid_newton(
+    grad, 0., 1., eps<double>, 0, &info.iters);
 
-  info<1> info;
   if (status == hybrid_status::DEGENERATE) {
     double F0 = tau0 + T0 + sh*norm2<n>(p0);
     double F1 = tau1 + T1 + sh*norm2<n>(p1);
@@ -283,21 +290,28 @@ updates::tri<RHR, n>::operator()(
   double dp[n];
   sub<n>(p1, p0, dp);
 
-  double nu[n], nufac[n];
+  double nu[n], nufac[n], dp_dot_dp = dot<n>(dp, dp);
 
-  auto const grad = [&] (double lam) {
+  // Returns dF/dlam and sets d2F to d2F/dlam2 (the derivative of
+  // dot(dp, p/|p|) with respect to lam is (|dp|^2 - dot(dp, p/|p|)^2)/|p|).
+  auto const grad = [&] (double lam, double & d2F) {
     axpy<n>(lam, dp, p0, nu);
     sub<n>(nu, p_fac, nufac);
-    scal_inplace<n>(1./norm2<n>(nu), nu);
-    scal_inplace<n>(1./norm2<n>(nufac), nufac);
-    return dtau + shfac*dot<n>(dp, nufac) + sh*dot<n>(dp, nu);
+    double const l = norm2<n>(nu), lfac = norm2<n>(nufac);
+    double const dp_dot_nu = dot<n>(dp, nu)/l;
+    double const dp_dot_nufac = dot<n>(dp, nufac)/lfac;
+    d2F = shfac*(dp_dot_dp - dp_dot_nufac*dp_dot_nufac)/lfac +
+      sh*(dp_dot_dp - dp_dot_nu*dp_dot_nu)/l;
+    return dtau + shfac*dp_dot_nufac + sh*dp_dot_nu;
   };
 
+  info<1> info;
+
   double arglam;
   hybrid_status status;
-  std::tie(arglam, status) = hybrid(grad, 0., 1.);
+  std::tie(arglam, status) = hybrid_newton(
+    grad, 0., 1., eps<double>, 0, &info.iters);
 
-  info<1> info;
   if (status == hybrid_status::DEGENERATE) {
     double F0 = tau0 + T0 + sh*norm2<n>(p0);
     double F1 = tau1 + T1 + sh*norm2<n>(p1);
@@ -414,11 +428,13 @@ updates::tri_bv<MP1, n, p0, p1>::operator()(
     return du + h*(l_lam*ds/2 + s_lam*dp_dot_p_lam/l_lam);
   };
 
+  info<1> info;
+
   double arglam;
   hybrid_status status;
-  std::tie(arglam, status) = hybrid(grad, 0., 1.);
-  
-  info<1> info;
+  std::tie(arglam, status) = hybrid(
+    grad, 0., 1., eps<double>, 0, &info.iters);
+
   if (status == hybrid_status::DEGENERATE) {
     double F0 = u0 + (s + s0)*h*sqrt(p0_dot_p0)/2;
     double F1 = u1 + (s + s1)*h*sqrt(p1_dot_p1)/2;
@@ -455,24 +471,29 @@ updates::tri<MP1, n>::operator()(
   double dp[n], nu[n], nufac[n];
   sub<n>(p1, p0, dp);
 
-  double s_lam, l_lam;
+  double s_lam, l_lam, dp_dot_dp = dot<n>(dp, dp);
 
-  auto const grad = [&] (double lam) {
+  // Returns dF/dlam and sets d2F to d2F/dlam2 (see tri<MP0, n>).
+  auto const grad = [&] (double lam, double & d2F) {
     axpy<n>(lam, dp, p0, nu);
     sub<n>(nu, p_fac, nufac);
     l_lam = norm2<n>(nu);
-    scal_inplace<n>(1./l_lam, nu);
-    scal_inplace<n>(1./norm2<n>(nufac), nufac);
+    double const lfac = norm2<n>(nufac);
+    double const dp_dot_nu = dot<n>(dp, nu)/l_lam;
+    double const dp_dot_nufac = dot<n>(dp, nufac)/lfac;
     s_lam = (s + s0 + ds*lam)/2;
-    return dtau + shfac*dot<n>(dp, nufac) +
-      h*(s_lam*dot<n>(dp, nu) + l_lam*ds/2);
+    d2F = shfac*(dp_dot_dp - dp_dot_nufac*dp_dot_nufac)/lfac +
+      h*(ds*dp_dot_nu + s_lam*(dp_dot_dp - dp_dot_nu*dp_dot_nu)/l_lam);
+    return dtau + shfac*dp_dot_nufac + h*(s_lam*dp_dot_nu + l_lam*ds/2);
   };
 
+  info<1> info;
+
   double arglam;
   hybrid_status status;
-  std::tie(arglam, status) = hybrid(grad, 0., 1.);
+  std::tie(arglam, status) = hybrid_newton(
+    grad, 0., 1., eps<double>, 0, &info.iters);
 
-  info<1> info;
   if (status == hybrid_status::DEGENERATE) {
     double F0 = tau0 + T0 + (s + s0)*h*norm2<n>(p0)/2;
     double F1 = tau1 + T1 + (s + s1)*h*norm2<n>(p1)/2;
@@ -541,6 +562,7 @@ updates::tri<MP1, n>::operator()(
     g = -dF1__(lam)/d2F1__(lam);
     lam = std::max(0., std::min(1., lam + g));
   } while (iter++ < 10 && fabs(g) > eps<double>);
+  info.iters = iter;
 
   if (iter == 10) {
     bool conv;
@@ -571,6 +593,7 @@ updates::tri<MP1, n>::operator()(
       F1[1] = F1__(lam[1]);
       conv = fabs(lam[1] - lam[0]) <= eps<double> ||
         fabs(F1[1] - F1[0]) <= eps<double>;
+      ++info.iters;
       lam[0] = lam[1];
       F1[0] = F1[1];
     } while (!conv);
@@ -0,0 +1,66 @@
+#ifndef __UPDATES_TRI_BATCH_HPP__
+#define __UPDATES_TRI_BATCH_HPP__
+
+#include "common.hpp"
+#include "cost_funcs.hpp"
+#include "simd.hpp"
+#include "updates.tri.hpp"
+
+namespace updates {
+
+/**
+ * A batch of triangle updates with bit vector offsets (see tri_bv)
+ * which all share the same update node. Instead of solving each
+ * triangle update as soon as its neighbors are known, the marcher
+ * pushes (u0, u1, s0, s1) for each admissible triangle along with the
+ * dot products of its offsets, and then gets the smallest value of
+ * all of them with a single call to `min_value'.
+ *
+ * For MP0 and RHR, min_value evaluates the closed form solutions used
+ * by tri_bv several lanes at a time (see simd.hpp), using masks and
+ * blends in place of tri_bv's branches. The values are the same as
+ * the ones tri_bv computes.
+ *
+ * MP1's triangle update is solved using hybrid, which doesn't batch
+ * well, so for MP1 `push' just does the scalar update right away.
+ */
+template <cost_func F, int n, int capacity>
+struct tri_bv_batch
+{
+  inline void reset(double s, double h) {
+    _size = 0;
+    _s = s;
+    _h = h;
+    _value = inf<double>;
+    _iters = 0;
+  }
+
+  template <int p0, int p1>
+  inline void push(double u0, double u1, double s0, double s1);
+
+  double min_value() const;
+
+  inline int size() const { return _size; }
+
+  // The number of root finding iterations done by the updates pushed
+  // since the last reset (only MP1's updates do any).
+  inline int iters() const { return _iters; }
+
+EIKONAL_PRIVATE:
+  template <class V>
+  inline typename V::reg eval(int k) const;
+
+  int _size {0}, _iters {0};
+  double _s, _h, _value;
+  double _u0[capacity], _u1[capacity];
+  double _s0[capacity], _s1[capacity];
+  double _l0[capacity], _l1[capacity];
+  double _p0_dot_p0[capacity], _dp_dot_p0[capacity],
+    _dp_dot_dp[capacity];
+};
+
+}
+
+#include "updates.tri_batch.impl.hpp"
+
+#endif // __UPDATES_TRI_BATCH_HPP__
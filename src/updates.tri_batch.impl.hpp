@@ -0,0 +1,159 @@
+#ifndef __UPDATES_TRI_BATCH_IMPL_HPP__
+#define __UPDATES_TRI_BATCH_IMPL_HPP__
+
+#include <src/config.hpp>
+
+#include <assert.h>
+
+#include "vecmath.hpp"
+
+template <cost_func F, int n, int capacity>
+template <int p0, int p1>
+void
+updates::tri_bv_batch<F, n, capacity>::push(
+  double u0, double u1, double s0, double s1)
+{
+  if (F == MP1) {
+    auto const info = updates::tri_bv<F, n, p0, p1>()(u0, u1, _s, s0, s1, _h);
+    _value = info.value < _value ? info.value : _value;
+    _iters += info.iters;
+    return;
+  }
+
+  static constexpr double _sqrt_table[4] = {
+    0.0,
+    1.0,
+    1.4142135623730951,
+    1.7320508075688772
+  };
+
+  constexpr int p0_dot_p0 = dot(p0, p0);
+  constexpr int p0_dot_p1 = dot(p0, p1);
+  constexpr int p1_dot_p1 = dot(p1, p1);
+
+  assert(_size < capacity);
+
+  int const k = _size++;
+  _u0[k] = u0;
+  _u1[k] = u1;
+  _s0[k] = s0;
+  _s1[k] = s1;
+  _l0[k] = _sqrt_table[p0_dot_p0];
+  _l1[k] = _sqrt_table[p1_dot_p1];
+  _p0_dot_p0[k] = p0_dot_p0;
+  _dp_dot_p0[k] = p0_dot_p1 - p0_dot_p0;
+  _dp_dot_dp[k] = p1_dot_p1 - 2*p0_dot_p1 + p0_dot_p0;
+}
+
+template <cost_func F, int n, int capacity>
+double
+updates::tri_bv_batch<F, n, capacity>::min_value() const
+{
+  if (F == MP1) {
+    return _value;
+  }
+
+  using V = simd::native;
+
+  // Do as many whole registers as we can, and then finish the batch
+  // off one lane at a time (most batches are shorter than a register,
+  // see simd.hpp).
+  int k = 0;
+  double value = inf<double>;
+  if (_size >= V::width) {
+    typename V::reg values = V::set1(inf<double>);
+    for (; k + V::width <= _size; k += V::width) {
+      values = V::min(values, eval<V>(k));
+    }
+    value = V::hmin(values);
+  }
+  for (; k < _size; ++k) {
+    value = simd::scalar::min(value, eval<simd::scalar>(k));
+  }
+  return value;
+}
+
+/**
+ * Evaluate lanes k through k + V::width - 1 of the batch. This is
+ * tri_bv<MP0 or RHR, ...>::operator() with its branches replaced by
+ * blends---the operations are done in the same order, so the results
+ * are the same.
+ */
+template <cost_func F, int n, int capacity>
+template <class V>
+typename V::reg
+updates::tri_bv_batch<F, n, capacity>::eval(int k) const
+{
+  using reg = typename V::reg;
+  using mask = typename V::mask;
+
+  reg const u0 = V::load(&_u0[k]), u1 = V::load(&_u1[k]);
+  reg const s0 = V::load(&_s0[k]), s1 = V::load(&_s1[k]);
+  reg const p0_dot_p0 = V::load(&_p0_dot_p0[k]);
+  reg const dp_dot_p0 = V::load(&_dp_dot_p0[k]);
+  reg const dp_dot_dp = V::load(&_dp_dot_dp[k]);
+  reg const s = V::set1(_s), h = V::set1(_h);
+  reg const zero = V::set1(0), one = V::set1(1), two = V::set1(2);
+
+  reg const du = V::sub(u1, u0);
+
+  // The cost of the update restricted to each edge of the triangle,
+  // and the scale of the cost along the base of the triangle.
+  reg const sh = V::mul(s, h);
+  reg F0, F1, alpha;
+  if (F == MP0) {
+    reg const half = V::set1(0.5);
+    reg const s_half =
+      V::div(V::add(V::add(s, V::mul(half, s0)), V::mul(half, s1)), two);
+    alpha = V::div(V::neg(du), V::mul(s_half, h));
+    F0 = V::add(u0, V::div(V::mul(V::mul(h, V::add(s, s0)),
+                                  V::load(&_l0[k])), two));
+    F1 = V::add(u1, V::div(V::mul(V::mul(h, V::add(s, s1)),
+                                  V::load(&_l1[k])), two));
+  } else {
+    alpha = V::div(V::neg(du), sh);
+    F0 = V::add(u0, V::mul(sh, V::load(&_l0[k])));
+    F1 = V::add(u1, V::mul(sh, V::load(&_l1[k])));
+  }
+
+  reg const alpha_sq = V::mul(alpha, alpha);
+  reg const tmp = V::sub(alpha_sq, dp_dot_dp);
+  reg const a = V::mul(dp_dot_dp, tmp);
+  reg const b = V::mul(dp_dot_p0, tmp);
+  reg const c = V::sub(V::mul(alpha_sq, p0_dot_p0),
+                       V::mul(dp_dot_p0, dp_dot_p0));
+  reg const disc = V::sub(V::mul(b, b), V::mul(a, c));
+
+  // Lanes with disc < 0 or a == 0 compute garbage here, but are
+  // replaced by min(F0, F1) below.
+  reg const lhs = V::div(V::neg(b), a), rhs = V::div(V::sqrt(disc), a);
+  reg const lam1 = V::sub(lhs, rhs), lam2 = V::add(lhs, rhs);
+
+  auto const l = [&] (reg x) {
+    return V::sqrt(V::add(
+      V::mul(V::add(V::mul(dp_dot_dp, x), V::mul(two, dp_dot_p0)), x),
+      p0_dot_p0));
+  };
+  auto const check = [&] (reg x) {
+    return V::abs(V::sub(V::sub(V::mul(alpha, l(x)), dp_dot_p0),
+                         V::mul(dp_dot_dp, x)));
+  };
+  reg const lam = V::blend(V::lt(check(lam1), check(lam2)), lam2, lam1);
+
+  reg value;
+  if (F == MP0) {
+    reg const s_lam = V::add(V::add(s, V::mul(V::sub(one, lam), s0)),
+                             V::mul(lam, s1));
+    value = V::add(V::add(u0, V::mul(lam, du)),
+                   V::mul(V::div(V::mul(h, s_lam), two), l(lam)));
+  } else {
+    value = V::add(V::add(u0, V::mul(lam, du)), V::mul(sh, l(lam)));
+  }
+  value = V::blend(V::gt(lam, one), value, F1);
+  value = V::blend(V::lt(lam, zero), value, F0);
+
+  mask const degenerate = V::lor(V::lt(disc, zero), V::eq(a, zero));
+  return V::blend(degenerate, value, V::blend(V::lt(F0, F1), F1, F0));
+}
+
+#endif // __UPDATES_TRI_BATCH_IMPL_HPP__
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "batch_marcher_3d.hpp"
+#include "olim3d.hpp"
+
+/**
+ * Check that each solve done by batch_marcher_3d is exactly the same
+ * as solving the same problem with a single marcher.
+ */
+template <class olim>
+void agrees_with_serial(int num_threads) {
+  int height = 9, width = 11, depth = 10;
+  double h = 0.2;
+
+  std::vector<double> s_cache(height*width*depth);
+  for (int k = 0; k < depth; ++k) {
+    for (int j = 0; j < width; ++j) {
+      for (int i = 0; i < height; ++i) {
+        s_cache[height*(width*k + j) + i] = s1(h*j - 1, h*i - 1, h*k - 1);
+      }
+    }
+  }
+
+  using batch_t = batch_marcher_3d<olim>;
+  std::vector<std::vector<typename batch_t::boundary_node>> sources = {
+    {{0, 0, 0, 0.0}},
+    {{4, 5, 6, 0.0}},
+    {{8, 10, 9, 0.5}, {1, 2, 3, 0.0}},
+    {},
+    {{2, 7, 1, 1.0}},
+  };
+
+  int size = height*width*depth;
+  std::vector<double> out(sources.size()*size);
+  batch_t batch {height, width, depth, h, s_cache.data(), num_threads};
+  batch.run(sources, out.data());
+
+  for (size_t l = 0; l < sources.size(); ++l) {
+    olim m {height, width, depth, h, s_cache.data()};
+    for (auto const & n: sources[l]) {
+      m.add_boundary_node(n.i, n.j, n.k, n.value);
+    }
+    m.run();
+    for (int k = 0; k < depth; ++k) {
+      for (int j = 0; j < width; ++j) {
+        for (int i = 0; i < height; ++i) {
+          ASSERT_EQ(out[l*size + height*(width*k + j) + i],
+                    m.get_value(i, j, k));
+        }
+      }
+    }
+  }
+}
+
+TEST (batch_marcher_3d, agrees_with_serial) {
+  for (int num_threads: {1, 2, 4}) {
+    agrees_with_serial<olim6_rhr>(num_threads);
+    agrees_with_serial<olim26_mp0>(num_threads);
+    agrees_with_serial<olim3d_hu_mp1>(num_threads);
+    agrees_with_serial<olim18_mp1_compact>(num_threads);
+    agrees_with_serial<olim26_rhr_float>(num_threads);
+  }
+}
+
+TEST (batch_marcher_3d, run_can_be_called_again) {
+  int n = 6, size = n*n*n;
+  std::vector<double> s_cache(size, 1.0);
+  batch_marcher_3d<olim18_rhr> batch {n, n, n, 1.0, s_cache.data(), 2};
+
+  std::vector<double> out(3*size);
+  batch.run({{{0, 0, 0, 0.0}}, {{5, 5, 5, 0.0}}, {{1, 4, 2, 0.0}}},
+            out.data());
+
+  // The marchers are reused, so this checks that they're reset
+  // properly in between solves.
+  std::vector<double> out_again(2*size);
+  batch.run({{{1, 4, 2, 0.0}}, {{0, 0, 0, 0.0}}}, out_again.data());
+  for (int l = 0; l < size; ++l) {
+    ASSERT_EQ(out_again[l], out[2*size + l]);
+    ASSERT_EQ(out_again[size + l], out[l]);
+  }
+}
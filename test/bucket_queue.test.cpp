@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include "bucket_queue.hpp"
+#include "node.hpp"
+#include "olim.hpp"
+#include "olim3d.hpp"
+
+// Mimic what the marchers do: pop the front node and then mark it
+// valid (which makes any of its remaining entries stale).
+static void accept_front(bucket_queue<node> & q) {
+  auto front = q.front();
+  q.pop_front();
+  front->set_valid();
+}
+
+TEST (bucket_queue, empty_works) {
+  bucket_queue<node> q {16};
+  ASSERT_TRUE(q.empty());
+}
+
+TEST (bucket_queue, size_works) {
+  bucket_queue<node> q {16};
+  node n[] = {
+    {0, 0, 1, state::trial},
+    {0, 0, 2, state::trial},
+    {0, 0, 3, state::trial}
+  };
+  ASSERT_TRUE(q.size() == 0);
+  q.insert(&n[1]);
+  q.insert(&n[0]);
+  q.insert(&n[2]);
+  ASSERT_TRUE(q.size() == 3);
+  n[0].set_value(0.5);
+  q.swim(&n[0]);
+  ASSERT_TRUE(q.size() == 3);
+  accept_front(q);
+  ASSERT_TRUE(q.size() == 2);
+  accept_front(q);
+  accept_front(q);
+  ASSERT_TRUE(q.size() == 0);
+}
+
+TEST (bucket_queue, insert_works) {
+  bucket_queue<node> q {16};
+  node n[] = {
+    {0, 0, 1, state::trial},
+    {0, 0, 2, state::trial},
+    {0, 0, 3, state::trial}
+  };
+  q.insert(&n[2]);
+  q.insert(&n[1]);
+  q.insert(&n[0]);
+  for (int i = 0; i < 3; ++i) {
+    node * front = q.front();
+    ASSERT_TRUE(front == &n[i]);
+    ASSERT_TRUE(front->get_value() == i + 1);
+    accept_front(q);
+  }
+  ASSERT_TRUE(q.empty());
+}
+
+TEST (bucket_queue, swim_works) {
+  bucket_queue<node> q {16};
+  node n[] = {
+    {0, 0, 1, state::trial},
+    {0, 0, 2, state::trial},
+    {0, 0, 3, state::trial}
+  };
+  q.insert(&n[0]);
+  q.insert(&n[1]);
+  q.insert(&n[2]);
+  n[2].set_value(0);
+  q.swim(&n[2]);
+  node * front = q.front();
+  ASSERT_TRUE(front == &n[2]);
+  ASSERT_TRUE(front->get_value() == 0);
+}
+
+TEST (bucket_queue, nodes_in_same_bucket_are_fifo) {
+  bucket_queue<node> q {16};
+  q.set_bucket_width(1);
+  node n[] = {
+    {0, 0, 1.75, state::trial},
+    {0, 0, 1.25, state::trial},
+    {0, 0, 1.5, state::trial}
+  };
+  for (int i = 0; i < 3; ++i) {
+    q.insert(&n[i]);
+  }
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(q.front() == &n[i]);
+    accept_front(q);
+  }
+}
+
+TEST (bucket_queue, infinite_values_come_last) {
+  bucket_queue<node> q {4};
+  node n[] = {
+    {0, 0, inf<double>, state::trial},
+    {0, 0, inf<double>, state::trial},
+    {0, 0, 100, state::trial}
+  };
+  q.insert(&n[0]);
+  q.insert(&n[1]);
+  q.insert(&n[2]);
+  n[1].set_value(1);
+  q.swim(&n[1]);
+  node * order[] = {&n[1], &n[2], &n[0]};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(q.front() == order[i]);
+    accept_front(q);
+  }
+  ASSERT_TRUE(q.empty());
+}
+
+TEST (bucket_queue, many_buckets_work) {
+  int const num = 1000;
+  bucket_queue<node> q {4};
+  q.set_bucket_width(0.5);
+  node * n = new node[num];
+  for (int i = 0; i < num; ++i) {
+    n[i] = {0, 0, (double) ((37*i) % num), state::trial};
+    q.insert(&n[i]);
+  }
+  double prev = -1;
+  while (!q.empty()) {
+    auto front = q.front();
+    ASSERT_TRUE(front->get_value() > prev);
+    prev = front->get_value();
+    accept_front(q);
+  }
+  delete[] n;
+}
+
+TEST (bucket_queue, olim8_rhr_agrees_with_heap) {
+  int n = 51;
+  double h = 2.0/(n - 1);
+  int i0 = (n - 1)/2;
+
+  olim8_rhr m_heap {n, n, h, (speed_func) s1, 1, 1};
+  m_heap.add_boundary_node(i0, i0);
+  m_heap.run();
+
+  olim<RHR, node, true, true, bucket_queue> m_bucket {
+    n, n, h, (speed_func) s1, 1, 1};
+  m_bucket.add_boundary_node(i0, i0);
+  m_bucket.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      ASSERT_NEAR(m_heap.get_value(i, j), m_bucket.get_value(i, j), 1e-3);
+    }
+  }
+}
+
+template <class olim_heap, class olim_bucket>
+testing::AssertionResult
+agrees_with_heap(int n, double tol) {
+  double h = 2.0/(n - 1);
+  int i0 = (n - 1)/2;
+
+  olim_heap m_heap {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_heap.add_boundary_node(i0, i0, i0);
+  m_heap.run();
+
+  olim_bucket m_bucket {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_bucket.add_boundary_node(i0, i0, i0);
+  m_bucket.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        double u_heap = m_heap.get_value(i, j, k);
+        double u_bucket = m_bucket.get_value(i, j, k);
+        if (fabs(u_heap - u_bucket) > tol) {
+          return testing::AssertionFailure()
+            << "|" << u_heap << " - " << u_bucket << "| > " << tol
+            << " at (" << i << ", " << j << ", " << k << ")";
+        }
+      }
+    }
+  }
+  return testing::AssertionSuccess();
+}
+
+TEST (bucket_queue, olim6_rhr_agrees_with_heap) {
+  ASSERT_TRUE((agrees_with_heap<
+                 olim6_rhr, olim3d_rhr<olim6_groups, bucket_queue>>(21, 1e-3)));
+}
+
+TEST (bucket_queue, olim26_mp1_agrees_with_heap) {
+  ASSERT_TRUE((agrees_with_heap<
+                 olim26_mp1, olim3d_mp1<olim26_groups, bucket_queue>>(21, 1e-12)));
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "dary_heap.hpp"
+#include "node.hpp"
+#include "olim3d.hpp"
+
+TEST (dary_heap, empty_works) {
+  heap4<node> h {16};
+  ASSERT_TRUE(h.empty());
+}
+
+TEST (dary_heap, size_works) {
+  node n[] = {{0, 0, 1}, {0, 0, 2}, {0, 0, 3}};
+  heap4<node> h {16};
+  h.set_nodes(n, 3);
+  ASSERT_TRUE(h.size() == 0);
+  h.insert(&n[1]);
+  h.insert(&n[0]);
+  h.insert(&n[2]);
+  ASSERT_TRUE(h.size() == 3);
+  h.pop_front();
+  ASSERT_TRUE(h.size() == 2);
+  h.pop_front();
+  h.pop_front();
+  ASSERT_TRUE(h.size() == 0);
+}
+
+TEST (dary_heap, insert_works) {
+  node n[] = {{0, 0, 1}, {0, 0, 2}, {0, 0, 3}};
+  heap4<node> h {16};
+  h.set_nodes(n, 3);
+  h.insert(&n[2]);
+  h.insert(&n[1]);
+  h.insert(&n[0]);
+  for (int i = 0; i < 3; ++i) {
+    node * front = h.front();
+    ASSERT_TRUE(front == &n[i]);
+    ASSERT_TRUE(front->get_value() == i + 1);
+    h.pop_front();
+  }
+}
+
+TEST (dary_heap, swim_works) {
+  node n[] = {{0, 0, 1}, {0, 0, 2}, {0, 0, 3}};
+  heap4<node> h {16};
+  h.set_nodes(n, 3);
+  h.insert(&n[0]);
+  h.insert(&n[1]);
+  h.insert(&n[2]);
+  n[2].set_value(0);
+  h.swim(&n[2]);
+  node * front = h.front();
+  ASSERT_TRUE(front == &n[2]);
+  ASSERT_TRUE(front->get_value() == 0);
+}
+
+template <class heap_t>
+void random_inserts_and_swims_work() {
+  int const num = 1000;
+  std::mt19937 gen {0};
+  std::uniform_real_distribution<double> dist {0, 1};
+
+  node * n = new node[num];
+  heap_t h {2};
+  h.set_nodes(n, num);
+  for (int i = 0; i < num; ++i) {
+    n[i] = {0, 0, dist(gen)};
+    h.insert(&n[i]);
+  }
+  for (int i = 0; i < num; i += 3) {
+    n[i].set_value(n[i].get_value()*dist(gen));
+    h.swim(&n[i]);
+  }
+  double prev = -1;
+  while (!h.empty()) {
+    ASSERT_TRUE(h.front()->get_value() >= prev);
+    prev = h.front()->get_value();
+    h.pop_front();
+  }
+  delete[] n;
+}
+
+TEST (dary_heap, random_inserts_and_swims_work) {
+  random_inserts_and_swims_work<heap4<node>>();
+  random_inserts_and_swims_work<heap8<node>>();
+}
+
+TEST (dary_heap, olim18_mp0_agrees_with_heap) {
+  int n = 21;
+  double h = 2.0/(n - 1);
+  int i0 = (n - 1)/2;
+
+  olim18_mp0 m_heap {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_heap.add_boundary_node(i0, i0, i0);
+  m_heap.run();
+
+  olim3d_mp0<olim18_groups, heap4> m_heap4 {
+    n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_heap4.add_boundary_node(i0, i0, i0);
+  m_heap4.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_DOUBLE_EQ(m_heap.get_value(i, j, k), m_heap4.get_value(i, j, k));
+      }
+    }
+  }
+}
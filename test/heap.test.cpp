@@ -55,3 +55,18 @@ TEST (heap, swim_works) {
   ASSERT_TRUE(front == &n[2]);
   ASSERT_TRUE(front->get_value() == 0);
 }
+
+TEST (heap, reserve_works) {
+  heap<node> h {2};
+  node n[] = {{0, 0, 3}, {0, 0, 1}, {0, 0, 2}};
+  h.insert(&n[0]);
+  h.insert(&n[1]);
+  h.reserve(64);
+  ASSERT_TRUE(h.capacity() == 64);
+  h.insert(&n[2]);
+  ASSERT_TRUE(h.front() == &n[1]);
+  h.pop_front();
+  ASSERT_TRUE(h.front() == &n[2]);
+  h.reserve(4);
+  ASSERT_TRUE(h.capacity() == 64);
+}
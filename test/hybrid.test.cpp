@@ -3,6 +3,7 @@
 #include <cmath>
 #include <tuple>
 
+#include "common.hpp"
 #include "hybrid.hpp"
 
 /**
@@ -36,3 +37,77 @@ TEST (hybrid, find_zero_of_quartic_test) {
   ASSERT_DOUBLE_EQ(opt, 1./3);
   ASSERT_TRUE(status == hybrid_status::OK);
 }
+
+TEST (hybrid, samesign_agrees_with_sgn) {
+  double const xs[] = {-inf<double>, -1, -0.0, 0, 1, inf<double>};
+  for (double a: xs) {
+    for (double b: xs) {
+      ASSERT_EQ(samesign(a, b), sgn(a) == sgn(b));
+    }
+  }
+}
+
+/**
+ * Same as minimize_quartic_test, using Newton's method with f''.
+ */
+TEST (hybrid, newton_minimize_quartic_test) {
+  auto const df = [] (double x, double & d2f) {
+    d2f = 12*std::pow(x - 0.5, 2) + 2;
+    return 4*std::pow(x - 0.5, 3) + 2*(x - 0.5);
+  };
+  double opt;
+  hybrid_status status;
+  std::tie(opt, status) = hybrid_newton(df, 0., 1.);
+  ASSERT_DOUBLE_EQ(opt, 0.5);
+  ASSERT_TRUE(status == hybrid_status::OK);
+}
+
+/**
+ * Same as find_zero_of_quartic_test, using Newton's method. This
+ * should take fewer iterations than hybrid does.
+ */
+TEST (hybrid, newton_find_zero_of_quartic_test) {
+  auto const f = [] (double x) {
+    using std::pow;
+    double x0 = x - 1./3;
+    return pow(x0, 4) - pow(x0, 3) + pow(x0, 2) - x0;
+  };
+  auto const fdf = [&] (double x, double & df) {
+    using std::pow;
+    double x0 = x - 1./3;
+    df = 4*pow(x0, 3) - 3*pow(x0, 2) + 2*x0 - 1;
+    return f(x);
+  };
+  double opt;
+  hybrid_status status;
+  int iters, newton_iters;
+  std::tie(opt, status) = hybrid(f, 0., 1., eps<double>, 0, &iters);
+  ASSERT_DOUBLE_EQ(opt, 1./3);
+  ASSERT_TRUE(status == hybrid_status::OK);
+  std::tie(opt, status) = hybrid_newton(fdf, 0., 1., eps<double>, 0,
+                                        &newton_iters);
+  ASSERT_DOUBLE_EQ(opt, 1./3);
+  ASSERT_TRUE(status == hybrid_status::OK);
+  ASSERT_GT(iters, 0);
+  ASSERT_GT(newton_iters, 0);
+  ASSERT_LT(newton_iters, iters);
+}
+
+TEST (hybrid, iteration_cap_works) {
+  auto const f = [] (double x) { return x*x*x - 0.1; };
+  auto const fdf = [&] (double x, double & df) {
+    df = 3*x*x;
+    return f(x);
+  };
+  double opt;
+  hybrid_status status;
+  int iters;
+  std::tie(opt, status) = hybrid(f, 0., 1., eps<double>, 2, &iters);
+  ASSERT_EQ(iters, 2);
+  ASSERT_TRUE(status == hybrid_status::OK);
+  ASSERT_TRUE(0 <= opt && opt <= 1);
+  std::tie(opt, status) = hybrid_newton(fdf, 0., 1., eps<double>, 1, &iters);
+  ASSERT_EQ(iters, 1);
+  ASSERT_TRUE(status == hybrid_status::OK);
+  ASSERT_TRUE(0 <= opt && opt <= 1);
+}
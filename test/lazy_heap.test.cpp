@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "lazy_heap.hpp"
+#include "node.hpp"
+#include "olim3d.hpp"
+
+// Mimic what the marchers do: pop the front node and then mark it
+// valid (which makes any of its remaining entries stale).
+static node * accept_front(lazy_heap4<node> & h) {
+  auto front = h.front();
+  h.pop_front();
+  front->set_valid();
+  return front;
+}
+
+TEST (lazy_heap, empty_works) {
+  lazy_heap4<node> h {16};
+  ASSERT_TRUE(h.empty());
+}
+
+TEST (lazy_heap, size_works) {
+  node n[] = {
+    {0, 0, 1, state::trial},
+    {0, 0, 2, state::trial},
+    {0, 0, 3, state::trial}
+  };
+  lazy_heap4<node> h {16};
+  h.set_nodes(n, 3);
+  h.insert(&n[1]);
+  h.insert(&n[0]);
+  h.insert(&n[2]);
+  ASSERT_TRUE(h.size() == 3);
+  n[2].set_value(0);
+  h.swim(&n[2]);
+  ASSERT_TRUE(h.size() == 3);
+  accept_front(h);
+  ASSERT_TRUE(h.size() == 2);
+  accept_front(h);
+  accept_front(h);
+  ASSERT_TRUE(h.empty());
+}
+
+TEST (lazy_heap, swim_works) {
+  node n[] = {
+    {0, 0, 1, state::trial},
+    {0, 0, 2, state::trial},
+    {0, 0, 3, state::trial}
+  };
+  lazy_heap4<node> h {16};
+  h.set_nodes(n, 3);
+  h.insert(&n[0]);
+  h.insert(&n[1]);
+  h.insert(&n[2]);
+  n[2].set_value(0);
+  h.swim(&n[2]);
+  n[1].set_value(0.5);
+  h.swim(&n[1]);
+  node * order[] = {&n[2], &n[1], &n[0]};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(accept_front(h) == order[i]);
+  }
+  ASSERT_TRUE(h.empty());
+}
+
+TEST (lazy_heap, random_inserts_and_swims_work) {
+  int const num = 1000;
+  std::mt19937 gen {0};
+  std::uniform_real_distribution<double> dist {0, 1};
+
+  node * n = new node[num];
+  lazy_heap4<node> h {2};
+  h.set_nodes(n, num);
+  for (int i = 0; i < num; ++i) {
+    n[i] = {0, 0, dist(gen), state::trial};
+    h.insert(&n[i]);
+  }
+  for (int i = 0; i < num; i += 3) {
+    n[i].set_value(n[i].get_value()*dist(gen));
+    h.swim(&n[i]);
+  }
+  double prev = -1;
+  int count = 0;
+  while (!h.empty()) {
+    auto front = accept_front(h);
+    ASSERT_TRUE(front->get_value() >= prev);
+    prev = front->get_value();
+    ++count;
+  }
+  ASSERT_EQ(count, num);
+  delete[] n;
+}
+
+TEST (lazy_heap, olim26_rhr_agrees_with_heap) {
+  int n = 21;
+  double h = 2.0/(n - 1);
+  int i0 = (n - 1)/2;
+
+  olim26_rhr m_heap {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_heap.add_boundary_node(i0, i0, i0);
+  m_heap.run();
+
+  olim3d_rhr<olim26_groups, lazy_heap4> m_lazy {
+    n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  m_lazy.add_boundary_node(i0, i0, i0);
+  m_lazy.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_DOUBLE_EQ(m_heap.get_value(i, j, k), m_lazy.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+TEST (lazy_heap, infinite_values_come_last) {
+  node n[] = {
+    {0, 0, inf<double>, state::trial},
+    {0, 0, inf<double>, state::trial},
+    {0, 0, 100, state::trial}
+  };
+  lazy_heap4<node> h {4};
+  h.set_nodes(n, 3);
+  h.insert(&n[0]);
+  h.insert(&n[1]);
+  h.insert(&n[2]);
+  n[1].set_value(1);
+  h.swim(&n[1]);
+  node * order[] = {&n[1], &n[2], &n[0]};
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(accept_front(h) == order[i]);
+  }
+  ASSERT_TRUE(h.empty());
+}
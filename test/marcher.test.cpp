@@ -35,3 +35,34 @@ TEST (marcher, fractional_add_boundaries_is_correct_with_nonconstant_slowness) {
     ASSERT_DOUBLE_EQ(o.get_value(1, 1), (s + S[3])*h*l[3]/2);
   }
 }
+
+TEST (marcher, borrowed_s_cache_is_not_copied) {
+  int n = 9;
+  std::shared_ptr<double> s_cache {
+    new double[n*n], std::default_delete<double[]>()};
+  for (int l = 0; l < n*n; ++l) {
+    s_cache.get()[l] = 1 + l % 3;
+  }
+
+  olim8_mp1 o {n, n, 0.5, s_cache.get()};
+  o.add_boundary_node(2, 5);
+  o.run();
+
+  // The borrowed cache keeps s_cache alive.
+  std::weak_ptr<double> weak {s_cache};
+  olim8_mp1 * o_borrowed = new olim8_mp1 {n, n, 0.5, s_cache};
+  ASSERT_EQ(o_borrowed->get_s_cache_data(), (void *) s_cache.get());
+  s_cache.reset();
+  ASSERT_FALSE(weak.expired());
+
+  o_borrowed->add_boundary_node(2, 5);
+  o_borrowed->run();
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      ASSERT_EQ(o.get_value(i, j), o_borrowed->get_value(i, j));
+    }
+  }
+
+  delete o_borrowed;
+  ASSERT_TRUE(weak.expired());
+}
@@ -69,3 +69,471 @@ TEST (marcher_3d, fractional_add_boundaries_is_correct_with_nonconstant_slowness
     ASSERT_DOUBLE_EQ(o.get_value(1, 1, 1), (s + S[7])*h*l[7]/2);
   }
 }
+
+TEST (marcher_3d, reset_and_rerun_works) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  olim6_rhr o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(0, 0, 0);
+  o.run();
+
+  olim6_rhr o_other {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o_other.add_boundary_node(n/2, n/2, n/2);
+  o_other.run();
+
+  o.reset();
+  o.add_boundary_node(n/2, n/2, n/2);
+  o.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_DOUBLE_EQ(o.get_value(i, j, k), o_other.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+// (A tiled node array doesn't have strides.)
+#if !MARCHER_3D_TILE_SIZE
+TEST (marcher_3d, node_pointer_and_strides_work_on_non_cubic_grid) {
+  int height = 5, width = 7, depth = 9;
+  olim26_mp0 o {height, width, depth, 0.25, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(0, width - 1, depth/2);
+  o.run();
+
+  auto nodes = o.get_node_pointer();
+  for (int i = 0; i < height; ++i) {
+    for (int j = 0; j < width; ++j) {
+      for (int k = 0; k < depth; ++k) {
+        auto const & n = nodes[i*o.get_node_stride(0) +
+                               j*o.get_node_stride(1) +
+                               k*o.get_node_stride(2)];
+        ASSERT_EQ(n.get_i(), i);
+        ASSERT_EQ(n.get_j(), j);
+        ASSERT_EQ(n.get_k(), k);
+        ASSERT_TRUE(n.is_valid());
+        ASSERT_EQ(n.get_value(), o.get_value(i, j, k));
+      }
+    }
+  }
+}
+#endif
+
+TEST (marcher_3d, copy_values_works_on_non_cubic_grid) {
+  int height = 5, width = 7, depth = 9;
+  olim26_mp0 o {height, width, depth, 0.25, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(0, width - 1, depth/2);
+  o.run();
+
+  std::vector<double> values(height*width*depth);
+  o.copy_values(values.data());
+  for (int i = 0; i < height; ++i) {
+    for (int j = 0; j < width; ++j) {
+      for (int k = 0; k < depth; ++k) {
+        ASSERT_EQ(values[height*(width*k + j) + i], o.get_value(i, j, k));
+        ASSERT_EQ(o(i, j, k).get_i(), i);
+        ASSERT_EQ(o(i, j, k).get_j(), j);
+        ASSERT_EQ(o(i, j, k).get_k(), k);
+      }
+    }
+  }
+}
+
+TEST (marcher_3d, running_through_abstract_marcher_works) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  olim26_rhr o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(n/2, n/2, n/2);
+  o.run();
+
+  olim26_rhr o_virtual {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o_virtual.add_boundary_node(n/2, n/2, n/2);
+  abstract_marcher<node_3d, heap> & m = o_virtual;
+  m.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_EQ(o.get_value(i, j, k), o_virtual.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+template <class olim, class olim_other>
+void nodes_agree_with_node_3d(bool factored, double tol = 0) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  int i0 = n/2;
+  node_3d::fac_center fc {(double) i0, (double) i0, (double) i0, 1.0};
+  node_3d::fac_center fc_corner {0, 0, 0, 1.0};
+
+  olim o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  olim_other o_other {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  if (factored) {
+    for (int i = i0 - 2; i <= i0 + 2; ++i) {
+      for (int j = i0 - 2; j <= i0 + 2; ++j) {
+        for (int k = i0 - 2; k <= i0 + 2; ++k) {
+          o.set_node_fac_center(i, j, k, &fc);
+          o_other.set_node_fac_center(i, j, k, &fc);
+        }
+      }
+    }
+    // Use a second factoring center to check that nodes don't get
+    // mixed up between different centers.
+    for (int i = 0; i < 2; ++i) {
+      for (int j = 0; j < 2; ++j) {
+        for (int k = 0; k < 2; ++k) {
+          o.set_node_fac_center(i, j, k, &fc_corner);
+          o_other.set_node_fac_center(i, j, k, &fc_corner);
+        }
+      }
+    }
+  }
+  o.add_boundary_node(i0, i0, i0);
+  o.run();
+  o_other.add_boundary_node(i0, i0, i0);
+  o_other.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        if (tol == 0) {
+          ASSERT_DOUBLE_EQ(o.get_value(i, j, k), o_other.get_value(i, j, k));
+        } else {
+          ASSERT_NEAR(o.get_value(i, j, k), o_other.get_value(i, j, k), tol);
+        }
+      }
+    }
+  }
+}
+
+TEST (marcher_3d, soa_nodes_agree_with_node_3d) {
+  nodes_agree_with_node_3d<
+    olim6_rhr, olim3d_bv<RHR, soa_node_3d, olim6_groups, heap4>>(false);
+  nodes_agree_with_node_3d<
+    olim26_mp1, olim3d_bv<MP1, soa_node_3d, olim26_groups, heap4>>(false);
+  nodes_agree_with_node_3d<
+    olim3d_hu_mp0, olim3d_hu<MP0, soa_node_3d, L1, 1, 2, heap8>>(false);
+}
+
+TEST (marcher_3d, factored_soa_nodes_agree_with_node_3d) {
+  nodes_agree_with_node_3d<
+    olim18_mp0, olim3d_bv<MP0, soa_node_3d, olim18_groups, heap4>>(true);
+  nodes_agree_with_node_3d<
+    olim3d_hu_rhr, olim3d_hu<RHR, soa_node_3d, L1, 1, 2, heap4>>(true);
+}
+
+TEST (marcher_3d, soa_reset_and_rerun_works) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  using olim_soa = olim3d_bv<RHR, soa_node_3d, olim6_groups, heap4>;
+  olim_soa o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(0, 0, 0);
+  o.run();
+
+  olim6_rhr o_other {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o_other.add_boundary_node(n/2, n/2, n/2);
+  o_other.run();
+
+  o.reset();
+  o.add_boundary_node(n/2, n/2, n/2);
+  o.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_DOUBLE_EQ(o.get_value(i, j, k), o_other.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+TEST (marcher_3d, compact_nodes_agree_with_node_3d) {
+  ASSERT_EQ(sizeof(compact_node_3d), 24ul);
+  nodes_agree_with_node_3d<olim6_rhr, olim6_rhr_compact>(false);
+  nodes_agree_with_node_3d<olim26_mp1, olim26_mp1_compact>(false);
+  nodes_agree_with_node_3d<olim3d_hu_rhr, olim3d_hu_rhr_compact>(false);
+}
+
+TEST (marcher_3d, factored_compact_nodes_agree_with_node_3d) {
+  nodes_agree_with_node_3d<olim18_mp0, olim18_mp0_compact>(true);
+  nodes_agree_with_node_3d<olim3d_hu_mp1, olim3d_hu_mp1_compact>(true);
+}
+
+TEST (marcher_3d, float_nodes_agree_with_node_3d) {
+  double tol = 1e-6;
+  nodes_agree_with_node_3d<olim6_rhr, olim6_rhr_float>(false, tol);
+  nodes_agree_with_node_3d<olim26_mp0, olim26_mp0_float>(false, tol);
+  nodes_agree_with_node_3d<olim3d_hu_mp1, olim3d_hu_mp1_float>(false, tol);
+  nodes_agree_with_node_3d<
+    olim26_rhr, olim3d_bv<RHR, soa_float_node_3d, olim26_groups, heap4>>(
+      false, tol);
+}
+
+template <class olim, class olim_tris_first>
+void tris_first_agrees_with_solve_all(speed_func_3d s, double tol = 0) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  int i0 = n/2;
+
+  olim o {n, n, n, h, s, 1, 1, 1};
+  o.add_boundary_node(i0, i0, i0);
+  o.run();
+
+  olim_tris_first o_tris_first {n, n, n, h, s, 1, 1, 1};
+  o_tris_first.add_boundary_node(i0, i0, i0);
+  o_tris_first.run();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        if (tol == 0) {
+          ASSERT_DOUBLE_EQ(
+            o.get_value(i, j, k), o_tris_first.get_value(i, j, k));
+        } else {
+          ASSERT_NEAR(
+            o.get_value(i, j, k), o_tris_first.get_value(i, j, k), tol);
+        }
+      }
+    }
+  }
+}
+
+// A triangle update is the restriction of a tetrahedron update to one
+// of its faces (except for MP0, which averages the speed over a
+// different set of nodes), so if the cost function is convex, the
+// KKT conditions hold at the best triangle update's minimizer exactly
+// when it's the tetrahedron update's minimizer. This is the case for
+// RHR. MP1 isn't convex when the speed varies rapidly, as s1 does, and
+// then the two strategies can find different local minima.
+TEST (marcher_3d, tris_first_agrees_with_solve_all) {
+  auto const s0 = (speed_func_3d) default_speed_func;
+  auto const s = (speed_func_3d) s1;
+
+  tris_first_agrees_with_solve_all<olim6_rhr, olim6_rhr_tris_first>(s);
+  tris_first_agrees_with_solve_all<olim18_rhr, olim18_rhr_tris_first>(s);
+  tris_first_agrees_with_solve_all<olim26_rhr, olim26_rhr_tris_first>(s);
+  tris_first_agrees_with_solve_all<
+    olim3d_hu_rhr, olim3d_hu_rhr_tris_first>(s);
+
+  tris_first_agrees_with_solve_all<olim6_mp1, olim6_mp1_tris_first>(s0);
+  tris_first_agrees_with_solve_all<olim18_mp1, olim18_mp1_tris_first>(s0);
+  tris_first_agrees_with_solve_all<olim26_mp1, olim26_mp1_tris_first>(s0);
+  tris_first_agrees_with_solve_all<
+    olim3d_hu_mp1, olim3d_hu_mp1_tris_first>(s0);
+
+  double tol = 1e-3;
+  tris_first_agrees_with_solve_all<olim26_mp0, olim26_mp0_tris_first>(
+    s, tol);
+  tris_first_agrees_with_solve_all<olim26_mp1, olim26_mp1_tris_first>(
+    s, tol);
+  tris_first_agrees_with_solve_all<
+    olim3d_hu_mp0, olim3d_hu_mp0_tris_first>(s, tol);
+  tris_first_agrees_with_solve_all<
+    olim3d_hu_mp1, olim3d_hu_mp1_tris_first>(s, tol);
+}
+
+// When only part of the domain is factored, updates near the edge of
+// the factored region are sensitive enough to rounding that the
+// single and double precision solutions can differ by more than
+// rounding error, so instead check that factoring the whole domain
+// still gives the exact solution.
+template <class olim>
+void factored_float_solution_is_exact(int n) {
+  double h = 2.0/(n - 1);
+  int i0 = n/2;
+  typename olim::node_t::fac_center fc {
+    (double) i0, (double) i0, (double) i0, 1.0};
+  olim o {n, n, n, h, (speed_func_3d) default_speed_func, 1, 1, 1};
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        o.set_node_fac_center(i, j, k, &fc);
+      }
+    }
+  }
+  o.add_boundary_node(i0, i0, i0);
+  o.run();
+  for (int i = 0; i < n; ++i) {
+    double y = h*i - 1;
+    for (int j = 0; j < n; ++j) {
+      double x = h*j - 1;
+      for (int k = 0; k < n; ++k) {
+        double z = h*k - 1;
+        ASSERT_NEAR(o.get_value(i, j, k), sqrt(x*x + y*y + z*z), 1e-6);
+      }
+    }
+  }
+}
+
+TEST (marcher_3d, factored_float_solution_is_exact) {
+  factored_float_solution_is_exact<olim18_mp1_float>(5);
+  factored_float_solution_is_exact<olim26_rhr_float>(11);
+  factored_float_solution_is_exact<olim3d_hu_rhr_float>(11);
+}
+
+template <class olim>
+void sweeping_agrees_with_marching(speed_func_3d s, double tol) {
+  int n = 15;
+  double h = 2.0/(n - 1);
+  int i0 = n/4, j0 = 2*n/3, k0 = n/2;
+
+  olim o {n, n, n, h, s, 1, 1, 1};
+  o.add_boundary_node(i0, j0, k0);
+  o.run();
+
+  olim o_sweep {n, n, n, h, s, 1, 1, 1};
+  o_sweep.add_boundary_node(i0, j0, k0);
+  o_sweep.run_sweeps();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        double u = o.get_value(i, j, k);
+        ASSERT_NEAR(u, o_sweep.get_value(i, j, k), tol*fmax(1, u));
+      }
+    }
+  }
+}
+
+template <class rhr, class mp0, class mp1>
+void sweeping_agrees_with_marching(speed_func_3d s, double tol) {
+  sweeping_agrees_with_marching<rhr>(s, tol);
+  sweeping_agrees_with_marching<mp0>(s, tol);
+  sweeping_agrees_with_marching<mp1>(s, tol);
+}
+
+// Sweeping only finds the same solution as marching if the updates
+// are causal (in which case the order the nodes are accepted in
+// doesn't matter). This is the case for RHR with olim6 and olim18,
+// and for every update when the speed is constant. Otherwise, the
+// solutions only agree up to a small fraction of the discretization
+// error (see below for olim3d_hu).
+TEST (marcher_3d, sweeping_agrees_with_marching) {
+  auto const s0 = (speed_func_3d) default_speed_func;
+  auto const s = (speed_func_3d) s1;
+
+  double tol = 1e-13;
+  sweeping_agrees_with_marching<olim6_rhr, olim6_mp0, olim6_mp1>(s0, tol);
+  sweeping_agrees_with_marching<olim18_rhr, olim18_mp0, olim18_mp1>(s0, tol);
+  sweeping_agrees_with_marching<olim26_rhr, olim26_mp0, olim26_mp1>(s0, tol);
+  sweeping_agrees_with_marching<
+    olim3d_hu_rhr, olim3d_hu_mp0, olim3d_hu_mp1>(s0, tol);
+
+  sweeping_agrees_with_marching<olim6_rhr>(s, tol);
+  sweeping_agrees_with_marching<olim18_rhr>(s, tol);
+
+  tol = 2e-3;
+  sweeping_agrees_with_marching<olim6_rhr, olim6_mp0, olim6_mp1>(s, tol);
+  sweeping_agrees_with_marching<olim18_rhr, olim18_mp0, olim18_mp1>(s, tol);
+  sweeping_agrees_with_marching<olim26_rhr, olim26_mp0, olim26_mp1>(s, tol);
+}
+
+template <class olim>
+void sweeping_is_as_accurate_as_marching() {
+  int n = 15;
+  double h = 2.0/(n - 1);
+  int i0 = n/2;
+
+  olim o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(i0, i0, i0);
+  o.run();
+
+  olim o_sweep {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o_sweep.add_boundary_node(i0, i0, i0);
+  o_sweep.run_sweeps();
+
+  double error = 0, error_sweep = 0;
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        double u = f1(h*j - 1, h*i - 1, h*k - 1);
+        error = fmax(error, fabs(o.get_value(i, j, k) - u));
+        error_sweep = fmax(error_sweep, fabs(o_sweep.get_value(i, j, k) - u));
+      }
+    }
+  }
+  ASSERT_LE(error_sweep, error*(1 + 1e-10));
+}
+
+// olim3d_hu's updates also aren't monotone: a smaller neighboring
+// value can change which triangle update it uses to pick the
+// tetrahedron updates it does. Its sweeping and marching solutions
+// can differ by a few percent of the discretization error, so just
+// check that sweeping is as accurate.
+TEST (marcher_3d, sweeping_is_as_accurate_as_marching) {
+  sweeping_is_as_accurate_as_marching<olim3d_hu_rhr>();
+  sweeping_is_as_accurate_as_marching<olim3d_hu_mp0>();
+  sweeping_is_as_accurate_as_marching<olim3d_hu_mp1>();
+}
+
+TEST (marcher_3d, sweeping_stops_after_max_sweeps) {
+  int n = 11;
+  olim26_rhr o {n, n, n, 2.0/(n - 1), (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(n/2, n/2, n/2);
+  ASSERT_EQ(o.run_sweeps(3), 3);
+  ASSERT_GT(o.run_sweeps(), 1);
+  ASSERT_EQ(o.run_sweeps(), 1);
+}
+
+TEST (marcher_3d, sweeping_after_reset_works) {
+  int n = 11;
+  double h = 2.0/(n - 1);
+  olim18_mp1 o {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o.add_boundary_node(0, 0, 0);
+  o.run_sweeps();
+
+  olim18_mp1 o_other {n, n, n, h, (speed_func_3d) s1, 1, 1, 1};
+  o_other.add_boundary_node(n/2, n/2, n/2);
+  o_other.run_sweeps();
+
+  o.reset();
+  o.add_boundary_node(n/2, n/2, n/2);
+  o.run_sweeps();
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_EQ(o.get_value(i, j, k), o_other.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+TEST (marcher_3d, borrowed_s_cache_is_not_copied) {
+  int n = 7;
+  std::shared_ptr<double> s_cache {
+    new double[n*n*n], std::default_delete<double[]>()};
+  for (int l = 0; l < n*n*n; ++l) {
+    s_cache.get()[l] = 1 + l % 3;
+  }
+
+  olim26_mp1 o {n, n, n, 0.5, s_cache.get()};
+  o.add_boundary_node(1, 2, 3);
+  o.run();
+
+  // The borrowed cache keeps s_cache alive (unless the layout is
+  // tiled, in which case the cache is reordered into a copy).
+  std::weak_ptr<double> weak {s_cache};
+  olim26_mp1 * o_borrowed = new olim26_mp1 {n, n, n, 0.5, s_cache};
+  if (!olim26_mp1::is_tiled) {
+    ASSERT_EQ(o_borrowed->get_s_cache_data(), (void *) s_cache.get());
+  }
+  s_cache.reset();
+  ASSERT_EQ(weak.expired(), olim26_mp1::is_tiled);
+
+  o_borrowed->add_boundary_node(1, 2, 3);
+  o_borrowed->run();
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_EQ(o.get_value(i, j, k), o_borrowed->get_value(i, j, k));
+      }
+    }
+  }
+
+  delete o_borrowed;
+  ASSERT_TRUE(weak.expired());
+}
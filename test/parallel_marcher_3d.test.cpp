@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "olim3d.hpp"
+#include "parallel_marcher_3d.hpp"
+
+/**
+ * Solve the same problem with `olim' and with parallel_marcher_3d
+ * (using `olim' for each block), and check that the solutions agree
+ * to within `tol' (relative to the serial solution). If `sweep' is
+ * set, parallel_marcher_3d sweeps instead of marching.
+ */
+template <class olim>
+void agrees_with_serial(
+  speed_func_3d speed, int block_size, int num_threads, double tol,
+  int n = 21, bool sweep = false)
+{
+  double h = 2.0/(n - 1);
+
+  // Put the source off center, near a corner of a block (for each of
+  // the block sizes used below), so that the front crosses blocks in
+  // every direction, and at different times.
+  int i0 = n/4, j0 = 2*n/3, k0 = n/2;
+
+  olim m {n, n, n, h, speed, 1, 1, 1};
+  m.add_boundary_node(i0, j0, k0);
+  m.run();
+
+  parallel_marcher_3d<olim> m_par {
+    n, n, n, h, speed, 1, 1, 1, block_size, num_threads};
+  m_par.add_boundary_node(i0, j0, k0);
+  if (sweep) {
+    m_par.run_sweeps();
+  } else {
+    m_par.run();
+  }
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        double u = m.get_value(i, j, k), u_par = m_par.get_value(i, j, k);
+        ASSERT_NEAR(u, u_par, tol*fmax(1, u));
+      }
+    }
+  }
+}
+
+/**
+ * RHR agrees with the serial marcher up to rounding. MP0's and MP1's
+ * updates aren't always causal, so their results depend on the order
+ * in which nodes are accepted (see, e.g.,
+ * olim26_mp0.result_is_symmetric), and only agree up to a small
+ * fraction of the discretization error.
+ */
+template <class rhr, class mp0, class mp1>
+void agrees_with_serial(speed_func_3d speed) {
+  for (int block_size: {4, 7, 32}) {
+    for (int num_threads: {1, 3}) {
+      agrees_with_serial<rhr>(speed, block_size, num_threads, 1e-13);
+      agrees_with_serial<mp0>(speed, block_size, num_threads, 2e-3);
+      agrees_with_serial<mp1>(speed, block_size, num_threads, 2e-3);
+    }
+  }
+}
+
+TEST (parallel_marcher_3d, olim6_agrees_with_serial) {
+  agrees_with_serial<olim6_rhr, olim6_mp0, olim6_mp1>(s1);
+}
+
+TEST (parallel_marcher_3d, olim18_agrees_with_serial) {
+  agrees_with_serial<olim18_rhr, olim18_mp0, olim18_mp1>(s1);
+}
+
+TEST (parallel_marcher_3d, olim26_agrees_with_serial) {
+  agrees_with_serial<olim26_rhr, olim26_mp0, olim26_mp1>(s1);
+}
+
+// See marcher_3d.sweeping_agrees_with_marching.
+TEST (parallel_marcher_3d, sweeping_agrees_with_serial) {
+  auto const s0 = (speed_func_3d) default_speed_func;
+  auto const s = (speed_func_3d) s1;
+  int n = 15;
+  for (int bs: {4, 7}) {
+    for (int nt: {1, 3}) {
+      agrees_with_serial<olim6_mp1>(s0, bs, nt, 1e-13, n, true);
+      agrees_with_serial<olim26_mp0>(s0, bs, nt, 1e-13, n, true);
+      agrees_with_serial<olim6_rhr>(s, bs, nt, 1e-13, n, true);
+      agrees_with_serial<olim18_rhr>(s, bs, nt, 1e-13, n, true);
+      agrees_with_serial<olim26_mp0>(s, bs, nt, 2e-3, n, true);
+      agrees_with_serial<olim26_mp1>(s, bs, nt, 2e-3, n, true);
+    }
+  }
+}
+
+TEST (parallel_marcher_3d, one_block_is_the_same_as_serial) {
+  int n = 11;
+  olim26_mp0 m {n, n, n, 1.0, (speed_func_3d) s1, 0.5, 0.5, 0.5};
+  m.add_boundary_node(2, 3, 4);
+  m.run();
+
+  parallel_marcher_3d<olim26_mp0> m_par {
+    n, n, n, 1.0, (speed_func_3d) s1, 0.5, 0.5, 0.5, n};
+  m_par.add_boundary_node(2, 3, 4);
+  m_par.run();
+  ASSERT_EQ(m_par.get_num_blocks(), 1);
+
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_EQ(m.get_value(i, j, k), m_par.get_value(i, j, k));
+      }
+    }
+  }
+}
+
+TEST (parallel_marcher_3d, works_with_boundary_nodes_on_block_faces) {
+  int n = 16, block_size = 4;
+  olim6_rhr m {n, n, n, 1.0};
+  parallel_marcher_3d<olim6_rhr> m_par {
+    n, n, n, 1.0, (speed_func_3d) default_speed_func, 0, 0, 0, block_size, 2};
+
+  // These are on the faces, edges and corners of blocks, so each is
+  // a ghost node of some of the blocks next to its own.
+  int inds[][3] = {{3, 3, 3}, {4, 9, 12}, {12, 7, 0}, {15, 15, 8}};
+  double values[] = {0.0, 1.5, 0.25, 3.0};
+  for (int l = 0; l < 4; ++l) {
+    m.add_boundary_node(inds[l][0], inds[l][1], inds[l][2], values[l]);
+    m_par.add_boundary_node(inds[l][0], inds[l][1], inds[l][2], values[l]);
+  }
+  m.run();
+  m_par.run();
+
+  for (int l = 0; l < 4; ++l) {
+    ASSERT_EQ(m_par.get_value(inds[l][0], inds[l][1], inds[l][2]), values[l]);
+  }
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      for (int k = 0; k < n; ++k) {
+        ASSERT_NEAR(m.get_value(i, j, k), m_par.get_value(i, j, k), 1e-13);
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+TEST (thread_pool, parallel_for_calls_each_index_once) {
+  for (int num_threads = 1; num_threads <= 4; ++num_threads) {
+    thread_pool pool {num_threads};
+    ASSERT_EQ(pool.size(), num_threads);
+    for (int n: {0, 1, 2, 7, 100}) {
+      std::vector<std::atomic<int>> counts(n);
+      pool.parallel_for(n, [&] (int i) { ++counts[i]; });
+      for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(counts[i], 1);
+      }
+    }
+  }
+}
+
+TEST (thread_pool, pool_can_be_reused) {
+  thread_pool pool {3};
+  std::atomic<int> sum {0};
+  for (int k = 0; k < 1000; ++k) {
+    pool.parallel_for(10, [&] (int i) { sum += i; });
+  }
+  ASSERT_EQ(sum, 45*1000);
+}
+
+TEST (thread_pool, default_size_is_positive) {
+  thread_pool pool;
+  ASSERT_GE(pool.size(), 1);
+}
@@ -2,8 +2,12 @@
 
 #include <src/config.hpp>
 
+#include <random>
+
 #include "common.hpp"
 #include "updates.tetra.hpp"
+#include "updates.tetra_batch.hpp"
+#include "updates.tri.hpp"
 
 using namespace updates;
 
@@ -834,3 +838,130 @@ TEST (updates_tetra, should_skip_works) {
     ASSERT_FALSE(skip);
   }
 }
+
+template <cost_func F, int p0, int p1, int p2>
+info<2> tetra_bv_with_fix(double u0, double u1, double u2, double s,
+                          double s0, double s1, double s2, double h)
+{
+  F_wkspc<F, 2> w;
+  set_args<F>(w, u0, u1, u2, s, s0, s1, s2, h);
+  cost_functor_bv<F, 3, p0, p1, p2> func {w};
+  info<2> info;
+  tetra_bv<F, 3, p0, p1, p2>()(func, info);
+  if (F == MP0 && info.inbounds()) {
+    func.set_lambda(info.lambda);
+    eval_mp1_fix(func.w, s, s0, s1, s2, h, info.lambda, info.value);
+  }
+  return info;
+}
+
+template <cost_func F, int p0, int p1, int p2>
+void push_tetra(tetra_bv_batch<F, 3, 16> & batch, info<2> * infos,
+                double u0, double u1, double u2, double s,
+                double s0, double s1, double s2, double h)
+{
+  infos[batch.size()] =
+    tetra_bv_with_fix<F, p0, p1, p2>(u0, u1, u2, s, s0, s1, s2, h);
+  batch.template push<p0, p1, p2>(u0, u1, u2, s0, s1, s2);
+}
+
+void assert_same(double x, double y) {
+  if (isinf(x) || isinf(y)) {
+    ASSERT_EQ(x, y);
+  } else {
+    ASSERT_DOUBLE_EQ(x, y);
+  }
+}
+
+template <cost_func F>
+void batch_agrees_with_tetra_bv() {
+  std::mt19937 gen {0};
+  std::uniform_real_distribution<double> U {0, 1}, S {0.5, 2};
+
+  tetra_bv_batch<F, 3, 16> batch;
+  info<2> infos[16];
+  for (int trial = 0; trial < 100; ++trial) {
+    double s = S(gen), h = 0.1*U(gen);
+    batch.reset(s, h);
+    for (int k = 0; k < 1 + trial % 16; ++k) {
+      // Keep the values close enough together that most of the
+      // minimizers are inside the tetrahedra.
+      double u0 = U(gen);
+      double u1 = u0 + h*(U(gen) - 0.5), u2 = u0 + h*(U(gen) - 0.5);
+      double s0 = S(gen), s1 = S(gen), s2 = S(gen);
+      switch (k % 4) {
+      case 0:
+        push_tetra<F, P001, P010, P100>(
+          batch, infos, u0, u1, u2, s, s0, s1, s2, h);
+        break;
+      case 1:
+        push_tetra<F, P001, P011, P101>(
+          batch, infos, u0, u1, u2, s, s0, s1, s2, h);
+        break;
+      case 2:
+        push_tetra<F, P001, P011, P111>(
+          batch, infos, u0, u1, u2, s, s0, s1, s2, h);
+        break;
+      case 3:
+        push_tetra<F, P011, P101, P110>(
+          batch, infos, u0, u1, u2, s, s0, s1, s2, h);
+        break;
+      }
+    }
+    batch.solve();
+    for (int k = 0; k < batch.size(); ++k) {
+      auto info = batch.get_info(k);
+      assert_same(info.value, infos[k].value);
+      assert_same(info.lambda[0], infos[k].lambda[0]);
+      assert_same(info.lambda[1], infos[k].lambda[1]);
+    }
+  }
+}
+
+TEST (updates_tetra, batch_agrees_with_tetra_bv) {
+  batch_agrees_with_tetra_bv<MP0>();
+  batch_agrees_with_tetra_bv<RHR>();
+}
+
+TEST (updates_tetra, mp1_warm_start_and_iteration_cap_work) {
+  std::mt19937 gen {0};
+  std::uniform_real_distribution<double> U {0, 1}, S {0.5, 2};
+
+  double p0[3] = {1, 0, 0}, p1[3] = {1, 1, 0}, p2[3] = {1, 1, 1};
+  geom_wkspc<2> g;
+  g.init<3>(p0, p1, p2);
+
+  int cold_iters = 0, warm_iters = 0, num_capped = 0;
+  for (int trial = 0; trial < 100; ++trial) {
+    double s = S(gen), h = 0.1*U(gen), u0 = U(gen);
+    double u1 = u0 + h*(U(gen) - 0.5), u2 = u0 + h*(U(gen) - 0.5);
+    double s0 = S(gen), s1 = S(gen), s2 = S(gen);
+
+    F_wkspc<MP1, 2> w;
+    set_args<MP1>(w, u0, u1, u2, s, s0, s1, s2, h);
+    cost_functor<MP1, 3, 2> func {w, g};
+
+    bool error;
+    info<2> cold;
+    cold_iters += tetra<MP1, 3>()(func, cold, &error);
+    ASSERT_FALSE(error);
+
+    // Warm start from the minimizer of the triangle update on the face
+    // (p0, p1), like olim3d_hu does.
+    info<2> warm;
+    warm.lambda[0] = tri<MP1, 3>()(p0, p1, u0, u1, s, s0, s1, h).lambda[0];
+    warm.lambda[1] = 0;
+    warm_iters += tetra<MP1, 3>()(func, warm, &error);
+    ASSERT_FALSE(error);
+    ASSERT_NEAR(warm.value, cold.value, 1e-13);
+
+    // With a cap of one iteration, we should get an upper bound.
+    info<2> capped;
+    int iters = tetra<MP1, 3>(1)(func, capped, &error);
+    ASSERT_EQ(iters, 1);
+    ASSERT_GE(capped.value, cold.value - 1e-13);
+    num_capped += error;
+  }
+  ASSERT_LT(warm_iters, cold_iters);
+  ASSERT_GT(num_capped, 0);
+}
@@ -2,8 +2,11 @@
 
 #include <src/config.hpp>
 
+#include <random>
+
 #include "common.hpp"
 #include "updates.tri.hpp"
+#include "updates.tri_batch.hpp"
 
 using namespace updates;
 
@@ -332,3 +335,55 @@ TEST (updates_tri, rhr_non_bv_tri_update_works) {
     ASSERT_DOUBLE_EQ(u1, sqrt2);
   }
 }
+
+template <cost_func F>
+void batch_agrees_with_tri_bv() {
+  std::mt19937 gen {0};
+  std::uniform_real_distribution<double> U {0, 1}, S {0.5, 2};
+
+  tri_bv_batch<F, 3, 18> batch;
+  for (int trial = 0; trial < 100; ++trial) {
+    double s = S(gen), h = 0.1*U(gen), u_min = inf<double>;
+    batch.reset(s, h);
+    for (int k = 0; k < 1 + trial % 18; ++k) {
+      // Spread the values out enough that some of the updates
+      // degenerate into line updates.
+      double u0 = U(gen), u1 = u0 + 0.2*h*(2*U(gen) - 1);
+      double s0 = S(gen), s1 = S(gen);
+      switch (k % 5) {
+      case 0:
+        batch.template push<P001, P010>(u0, u1, s0, s1);
+        u_min = std::min(
+          u_min, tri_bv<F, 3, P001, P010>()(u0, u1, s, s0, s1, h).value);
+        break;
+      case 1:
+        batch.template push<P001, P011>(u0, u1, s0, s1);
+        u_min = std::min(
+          u_min, tri_bv<F, 3, P001, P011>()(u0, u1, s, s0, s1, h).value);
+        break;
+      case 2:
+        batch.template push<P001, P111>(u0, u1, s0, s1);
+        u_min = std::min(
+          u_min, tri_bv<F, 3, P001, P111>()(u0, u1, s, s0, s1, h).value);
+        break;
+      case 3:
+        batch.template push<P011, P101>(u0, u1, s0, s1);
+        u_min = std::min(
+          u_min, tri_bv<F, 3, P011, P101>()(u0, u1, s, s0, s1, h).value);
+        break;
+      case 4:
+        batch.template push<P011, P111>(u0, u1, s0, s1);
+        u_min = std::min(
+          u_min, tri_bv<F, 3, P011, P111>()(u0, u1, s, s0, s1, h).value);
+        break;
+      }
+    }
+    ASSERT_DOUBLE_EQ(batch.min_value(), u_min);
+  }
+}
+
+TEST (updates_tri, batch_agrees_with_tri_bv) {
+  batch_agrees_with_tri_bv<MP0>();
+  batch_agrees_with_tri_bv<MP1>();
+  batch_agrees_with_tri_bv<RHR>();
+}